@@ -1,11 +1,21 @@
 #include "_tests.h"
+#include "_bench.h"
 
 tests::collection_type tests::_collection;
+bench::collection_type bench::_collection;
+bench::format bench::_format;
 
-int main()
+// "Algorithms bench" also runs the benchmarks after the tests, "Algorithms bench json" prints them as json
+int main(int argc, char* argv[])
 {
 	tests::run();
 
+	if (argc > 1 && std::string(argv[1]) == "bench")
+	{
+		bool json = argc > 2 && std::string(argv[2]) == "json";
+		bench::run(json ? bench::format::json : bench::format::csv);
+	}
+
     return 0;
 }
 
@@ -0,0 +1,47 @@
+#pragma once
+#include "header.h"
+
+// Naive range operations in O(n), the reference for tests and the baseline for benchmarks.
+template<typename T, T INF = T(1e9)>
+class AwesomeArray
+{
+	vector<T> _v;
+
+public:
+	void assign(int size) { _v.assign(size, T{}); }
+	void assign(int size, const T& value) { _v.assign(size, value); }
+	void assign(const vector<T>& v) { _v = v; }
+
+	void add(int l, int r, T val)
+	{
+		for (int i = l; i <= r; ++i) _v[i] += val;
+	}
+	void set(int l, int r, T val)
+	{
+		for (int i = l; i <= r; ++i) _v[i] = val;
+	}
+	void chmin(int l, int r, T val)
+	{
+		for (int i = l; i <= r; ++i) _v[i] = std::min(_v[i], val);
+	}
+	void chmax(int l, int r, T val)
+	{
+		for (int i = l; i <= r; ++i) _v[i] = std::max(_v[i], val);
+	}
+	template<typename TIterator>
+	void assign_range(int l, int r, TIterator first) { copy(first, first + (r - l + 1), _v.begin() + l); }
+	void add(int i, T val) { _v[i] += val; }
+	void set(int i, T val) { _v[i] = val; }
+	T sum(int l, int r)
+	{
+		T res = T{};
+		for (int i = l; i <= r; ++i) res += _v[i];
+		return res;
+	}
+	pair<T, int> min(int l, int r)
+	{
+		auto res = pair<T, int>(INF, -1);
+		for (int i = l; i <= r; ++i) res = std::min(res, make_pair(_v[i], i));
+		return res;
+	}
+};
@@ -0,0 +1,105 @@
+#pragma once
+#include "Fenwick.h"
+#include <cstdint>
+
+// Fenwik for arrays past the cache. The values are split into cache line blocks of Block
+// and kept as prefix sums inside their blocks, the block totals form the next level the same way,
+// until at most TopCells totals are left for a Fenwik that stays in the cache.
+// sum reads one cell per level, increment adds to the rest of one line per level
+// with a contiguous loop the compiler turns into SIMD, so both touch one line per level.
+// For 10^9 ints that is 4 block levels plus the top Fenwik, about 4 misses past the cache.
+template <typename T>
+class BlockedFenwik
+{
+private:
+	static const int Block = 64 / sizeof(T);
+	static const int TopCells = 1 << 16;
+
+	// cache line aligned
+	struct Level
+	{
+		vector<T> buf;
+		int align;
+		int size;
+
+		T* data() { return buf.data() + align; }
+		const T* data() const { return buf.data() + align; }
+	};
+
+	vector<Level> _levels;
+	Fenwik<T> _top;
+	int _size;
+
+public:
+	int size() const { return _size; }
+
+	void assign(int size)
+	{
+		assign(vector<T>(size, 0));
+	}
+
+	void assign(int size, T val)
+	{
+		assign(vector<T>(size, val));
+	}
+
+	// O(n)
+	void assign(const vector<T>& vals)
+	{
+		_size = vals.size();
+		_levels.clear();
+
+		vector<T> cur = vals;
+		while (_levels.empty() || cur.size() > TopCells)
+		{
+			_levels.emplace_back();
+			Level& level = _levels.back();
+			level.size = cur.size();
+			level.buf.assign(cur.size() + Block, 0);
+			level.align = 0;
+			while (reinterpret_cast<uintptr_t>(level.buf.data() + level.align) % 64 != 0) ++level.align;
+
+			T* a = level.data();
+			copy(all(cur), a);
+			vector<T> totals((cur.size() + Block - 1) / Block);
+			forn(b, totals.size())
+			{
+				int end = std::min(level.size, (b + 1) * Block);
+				for (int i = b * Block + 1; i < end; ++i) a[i] += a[i - 1];
+				totals[b] = a[end - 1];
+			}
+			cur.swap(totals);
+		}
+		_top.assign(cur);
+	}
+
+	void increment(int i, T val)
+	{
+		for (auto& level : _levels)
+		{
+			T* a = level.data();
+			int end = std::min(level.size, (i / Block + 1) * Block);
+			for (int j = i; j < end; ++j) a[j] += val;
+			i /= Block;
+		}
+		_top.increment(i, val);
+	}
+
+	T sum(int r) const
+	{
+		T res = 0;
+		// r is the last cell of the prefix on the level, the blocks before its block go to the next one
+		for (const auto& level : _levels)
+		{
+			if (r < 0) return res;
+			res += level.data()[r];
+			r = r / Block - 1;
+		}
+		return res + _top.sum(r);
+	}
+
+	T sum(int l, int r) const
+	{
+		return sum(r) - sum(l-1);
+	}
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include "header.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+
+// Fenwik for any number of threads calling increment and sum at the same time.
+// atomic: one tree, increment is a relaxed fetch_add on each cell of its path.
+// sharded: a tree per shard, a thread increments the shard its id hashes to and sum adds up the shards,
+// so only threads of the same shard contend on cells. Threads may share a shard, so increment
+// still uses fetch_add there.
+//
+// Consistency: an increment at i <= r reaches exactly one cell read by sum(r), so sum(r) counts
+// every concurrent increment either whole or not at all, and every increment that happens before it.
+// sum(l, r) is two prefix sums, a concurrent increment may be in one of them only.
+template <typename T>
+class ConcurrentFenwik
+{
+	static_assert(std::is_integral<T>::value, "fetch_add needs an integral type");
+
+public:
+	enum class mode { atomic, sharded };
+
+private:
+	using cells_type = unique_ptr<atomic<T>[]>;
+
+	vector<cells_type> _shards;
+	int _size;
+
+	static size_t thread_hash()
+	{
+		static thread_local size_t hash = std::hash<std::thread::id>()(std::this_thread::get_id());
+		return hash;
+	}
+
+	// cell i (1-based) keeps the sum of [i - (i & -i), i), as in Fenwik
+	void increment(atomic<T>* t, int i, T val)
+	{
+		for (++i; i <= _size; i += (i & -i))
+			t[i].fetch_add(val, memory_order_relaxed);
+	}
+
+	T sum(const atomic<T>* t, int r) const
+	{
+		T res = 0;
+		for (++r; r > 0; r -= (r & -r))
+			res += t[r].load(memory_order_relaxed);
+		return res;
+	}
+
+public:
+	int size() const { return _size; }
+
+	// Not thread safe. shards = 0 takes one per hardware thread, atomic mode has one.
+	void assign(int size, mode m = mode::atomic, int shards = 0)
+	{
+		if (m == mode::atomic) shards = 1;
+		else if (shards <= 0) shards = std::max<int>(1, std::thread::hardware_concurrency());
+
+		_size = size;
+		_shards.clear();
+		forn(s, shards)
+		{
+			cells_type t(new atomic<T>[size + 1]);
+			for (int i = 0; i <= size; ++i) t[i].store(0, memory_order_relaxed);
+			_shards.push_back(std::move(t));
+		}
+	}
+
+	void increment(int i, T val)
+	{
+		increment(_shards[thread_hash() % _shards.size()].get(), i, val);
+	}
+
+	T sum(int r) const
+	{
+		T res = 0;
+		for (const auto& t : _shards) res += sum(t.get(), r);
+		return res;
+	}
+
+	T sum(int l, int r) const
+	{
+		return sum(r) - sum(l-1);
+	}
+};
@@ -0,0 +1,420 @@
+#pragma once
+#include "PersistentSegmentTree.h"
+#include <atomic>
+#include <thread>
+
+namespace segment_tree
+{
+	namespace concurrent
+	{
+		// Epoch based grace periods. Readers count themselves under the parity of the current
+		// epoch in the slot their thread hashes to. Slots take a cache line each, so only readers
+		// of threads hashed to the same slot write a shared line.
+		class Epochs
+		{
+			static const int Slots = 64;
+
+			struct alignas(64) Slot
+			{
+				atomic<int> active[2];
+			};
+
+			Slot _slots[Slots];
+			atomic<int> _epoch;
+
+			static int thread_slot()
+			{
+				static thread_local int slot = int(std::hash<std::thread::id>()(std::this_thread::get_id()) % Slots);
+				return slot;
+			}
+
+		public:
+			Epochs() : _epoch(0)
+			{
+				for (auto& slot : _slots)
+				{
+					slot.active[0] = 0;
+					slot.active[1] = 0;
+				}
+			}
+
+			// returns the token for leave
+			int enter()
+			{
+				Slot& slot = _slots[thread_slot()];
+				while (true)
+				{
+					int e = _epoch.load();
+					slot.active[e & 1].fetch_add(1);
+					if (_epoch.load() == e) return thread_slot() * 2 + (e & 1);
+					slot.active[e & 1].fetch_sub(1);
+				}
+			}
+
+			void leave(int token)
+			{
+				_slots[token >> 1].active[token & 1].fetch_sub(1, memory_order_release);
+			}
+
+			// waits for all readers entered before the call
+			void synchronize()
+			{
+				int e = _epoch.fetch_add(1);
+				for (auto& slot : _slots)
+				{
+					while (slot.active[e & 1].load() != 0) std::this_thread::yield();
+				}
+			}
+		};
+
+		// One writer builds new versions of a persistent tree and publishes them,
+		// any number of readers query the last published one without locks.
+		// When the arena grows past GarbageFactor times the tree, the writer copies
+		// the published version into a fresh arena and frees the old one after a grace period.
+		template<typename TNode>
+		class Versions
+		{
+		public:
+			using tree_type = persistent::Tree<TNode>;
+			using iter = persistent::Iter<TNode>;
+
+		private:
+			static const int GarbageFactor = 8;
+
+			unique_ptr<tree_type> _arenas[2];
+			int _current = 0;
+			// arena index << 32 | root
+			atomic<uint64> _head;
+			mutable Epochs _epochs;
+
+			int root() const { return int(_head.load(memory_order_relaxed) & 0xffffffff); }
+
+			void publish(int arena, int root)
+			{
+				_head.store(uint64(arena) << 32 | uint64(root), memory_order_release);
+			}
+
+			void reclaim()
+			{
+				tree_type& tree = *_arenas[_current];
+				if (tree.count() < int64(GarbageFactor) * 2 * tree.size()) return;
+
+				int next = _current ^ 1;
+				vint roots{ root() };
+				_arenas[next].reset(new tree_type());
+				_arenas[next]->assign(tree, roots);
+				publish(next, roots[0]);
+
+				_epochs.synchronize();
+				_arenas[_current].reset();
+				_current = next;
+			}
+
+		public:
+			Versions() : _head(0) {}
+
+			// Writer.
+			// op.init(it), op.recalc(it)
+			template<typename TOperation>
+			void build(TOperation& op, int size)
+			{
+				int next = _current ^ 1;
+				_arenas[next].reset(new tree_type());
+				int root = persistent::build(op, *_arenas[next], size);
+				publish(next, root);
+
+				_epochs.synchronize();
+				_arenas[_current].reset();
+				_current = next;
+			}
+
+			// Writer.
+			// op.push(it), op.modify(it), op.recalc(it)
+			template<typename TOperation>
+			void modify(TOperation& op, const Query& q)
+			{
+				publish(_current, persistent::modify(op, *_arenas[_current], root(), q));
+				reclaim();
+			}
+
+			// Any thread.
+			// op.zero(), op.get(it, tag), op.down(it, tag), op.merge(r1, r2)
+			template<typename TOperation, typename TTag>
+			typename TOperation::result_type calc(TOperation& op, const Query& q, const TTag& tag) const
+			{
+				int token = _epochs.enter();
+				uint64 head = _head.load(memory_order_acquire);
+				tree_type& tree = *_arenas[head >> 32];
+				auto res = calc_const(op, iter(tree, int(head & 0xffffffff), 0), q, tag);
+				_epochs.leave(token);
+				return res;
+			}
+		};
+	}
+}
+
+
+// Single writer, lock-free readers: min may be called from any number of threads
+// concurrently with one thread calling assign and add.
+template<typename T, T INF = T(1e9)>
+class ConcurrentAddMinST
+{
+	struct Node
+	{
+		pair<T, int> minp;
+		T add;
+
+		void init(T val, int index)
+		{
+			minp.first = val;
+			minp.second = index;
+			add = 0;
+		}
+	};
+
+	using iter = segment_tree::persistent::Iter<Node>;
+	segment_tree::concurrent::Versions<Node> _versions;
+
+	struct calc_op
+	{
+		void push(const iter& it)
+		{
+			Node& node = *it;
+			if (node.add != 0)
+			{
+				segment_tree::modify_children(add_op(node.add), it);
+				node.minp.first += node.add;
+				node.add = 0;
+			}
+		}
+	};
+
+	struct mod_op : public calc_op
+	{
+		void recalc(const iter& it)
+		{
+			it->minp = std::min(it.left()->minp, it.right()->minp);
+		}
+	};
+
+	struct init_vec_op : public mod_op
+	{
+		const vector<T>& v;
+		init_vec_op(const vector<T>& v) : v(v) {}
+
+		void init(const iter& it)
+		{
+			it->init(v[it.leaf_index()], it.leaf_index());
+		}
+	};
+
+	struct init_const_op : public mod_op
+	{
+		T val;
+		init_const_op(const T& val) : val(val) {}
+
+		void init(const iter& it)
+		{
+			it->init(val, it.leaf_index());
+		}
+	};
+
+	struct add_op : public mod_op
+	{
+		T val;
+		add_op(const T& val) : val(val) {}
+
+		void modify(const iter& it)
+		{
+			it->add += val;
+		}
+	};
+
+	// tag is the sum of adds of the ancestors
+	struct min_op
+	{
+		using result_type = pair<T, int>;
+
+		result_type zero()
+		{
+			return result_type(INF, -1);
+		}
+		result_type get(const iter& it, T add)
+		{
+			return result_type(it->minp.first + it->add + add, it->minp.second);
+		}
+		T down(const iter& it, T add)
+		{
+			return it->add + add;
+		}
+		result_type merge(result_type left, result_type right)
+		{
+			return std::min(left, right);
+		}
+	};
+
+public:
+	void assign(int size, const T& val = 0)
+	{
+		_versions.build(init_const_op(val), size);
+	}
+	void assign(const vector<T>& vals)
+	{
+		_versions.build(init_vec_op(vals), vals.size());
+	}
+
+	pair<T, int> min(int l, int r) const
+	{
+		return _versions.calc(min_op(), segment_tree::Query(l, r), T(0));
+	}
+
+	void add(int l, int r, T val)
+	{
+		_versions.modify(add_op(val), segment_tree::Query(l, r));
+	}
+
+};
+
+
+// Single writer, lock-free readers: sum may be called from any number of threads
+// concurrently with one thread calling assign, add and set.
+template<typename T>
+class ConcurrentAddSetSumST
+{
+	static const int UNDEF = -1e9;
+
+	struct Tag
+	{
+		T add;
+		T set;
+		Tag() : add(0), set(UNDEF) {}
+	};
+
+	struct Node : public Tag
+	{
+		T sum;
+		Node() : sum(0) {}
+	};
+
+	using iter = segment_tree::persistent::Iter<Node>;
+	segment_tree::concurrent::Versions<Node> _versions;
+
+	struct calc_op
+	{
+		void push(const iter& it)
+		{
+			Node& node = *it;
+			if (node.set != UNDEF)
+			{
+				segment_tree::modify_children(set_op(node.set), it);
+				node.sum = node.set * it.len();
+				node.set = UNDEF;
+			}
+			else if (node.add != 0)
+			{
+				segment_tree::modify_children(add_op(node.add), it);
+				node.sum += node.add * it.len();
+				node.add = 0;
+			}
+		}
+	};
+
+	struct mod_op : public calc_op
+	{
+		void recalc(const iter& it)
+		{
+			it->sum = it.left()->sum + it.right()->sum;
+		}
+	};
+
+	struct init_vec_op : public mod_op
+	{
+		const vector<T>& v;
+		init_vec_op(const vector<T>& v) : v(v) {}
+
+		void init(const iter& it)
+		{
+			it->sum = v[it.leaf_index()];
+		}
+	};
+
+	struct add_op : public mod_op
+	{
+		T val;
+		add_op(const T& val) : val(val) {}
+
+		void modify(const iter& it)
+		{
+			Node& node = *it;
+			if (node.set != UNDEF)
+			{
+				node.set += val;
+			}
+			else
+			{
+				node.add += val;
+			}
+		}
+	};
+
+	struct set_op : public mod_op
+	{
+		T val;
+		set_op(const T& val) : val(val) {}
+
+		void modify(const iter& it) const
+		{
+			Node& node = *it;
+			node.add = 0;
+			node.set = val;
+		}
+	};
+
+	// tag is the modification of the ancestors, newer than the ones below
+	struct sum_op
+	{
+		using result_type = T;
+		T zero() { return 0; }
+		T get(const iter& it, const Tag& tag)
+		{
+			Tag t = down(it, tag);
+			return t.set != UNDEF ? t.set * it.len() : it->sum + t.add * it.len();
+		}
+		Tag down(const iter& it, const Tag& tag)
+		{
+			if (tag.set != UNDEF) return tag;
+
+			Tag res = *it;
+			if (res.set != UNDEF) res.set += tag.add;
+			else res.add += tag.add;
+			return res;
+		}
+		T merge(T left, T right) { return left + right; }
+	};
+
+public:
+	void assign(int size)
+	{
+		_versions.build(init_vec_op(vector<T>(size)), size);
+	}
+	void assign(const vector<T>& vals)
+	{
+		_versions.build(init_vec_op(vals), vals.size());
+	}
+
+	T sum(int l, int r) const
+	{
+		return _versions.calc(sum_op(), segment_tree::Query(l, r), Tag());
+	}
+
+	void add(int l, int r, T val)
+	{
+		_versions.modify(add_op(val), segment_tree::Query(l, r));
+	}
+
+	void set(int l, int r, T val)
+	{
+		_versions.modify(set_op(val), segment_tree::Query(l, r));
+	}
+
+};
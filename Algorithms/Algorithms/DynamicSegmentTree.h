@@ -0,0 +1,234 @@
+#pragma once
+#include "SegmentTree.h"
+
+namespace segment_tree
+{
+	// Trees over 64-bit coordinates, nodes are created when an update touches them.
+	namespace dynamic
+	{
+		struct Pos
+		{
+			int i;
+			int64 l, r;
+
+			Pos(int i, int64 l, int64 r) : i(i), l(l), r(r) {}
+
+			bool is_leaf() const { return l == r; }
+			int64 leaf_index() const { return l; }
+
+			int64 m() const { return l + ((r - l) >> 1); }
+			int64 len() const { return r - l + 1; }
+		};
+
+		struct Query
+		{
+			int64 l, r;
+
+			Query() {}
+			Query(int64 l, int64 r) : l(l), r(r) {}
+
+			bool has_common(const Pos& p) const { return !(r < p.l || l > p.r); }
+			bool includes(const Pos& p) const { return l <= p.l && r >= p.r; }
+		};
+
+		// Index based pool of nodes, deque keeps them in place while it grows.
+		// Node 0 is the root, missing children are -1.
+		template<typename TNode>
+		class Tree
+		{
+		public:
+			using node_type = TNode;
+
+			struct Cell
+			{
+				node_type node;
+				int left, right;
+			};
+
+		private:
+			deque<Cell> _cells;
+			// shared by all missing nodes for reading
+			node_type _empty;
+			int64 _lo, _hi;
+
+			int count(int i, int64 l, int64 r, const Query& q) const
+			{
+				if (i < 0 || q.r < l || q.l > r) return 0;
+
+				int64 m = Pos(i, l, r).m();
+				const Cell& c = _cells[i];
+				return 1 + count(c.left, l, m, q) + count(c.right, m + 1, r, q);
+			}
+
+		public:
+			int64 lo() const { return _lo; }
+			int64 hi() const { return _hi; }
+			int nodes() const { return _cells.size(); }
+			node_type& node(int i) { return i < 0 ? _empty : _cells[i].node; }
+
+			// coordinates [lo, hi], hi - lo + 1 must fit into int64
+			void assign(int64 lo, int64 hi)
+			{
+				_lo = lo;
+				_hi = hi;
+				_empty = node_type();
+				_cells.assign(1, Cell{ node_type(), -1, -1 });
+			}
+
+			// child of i, created when create is set, -1 if it is missing otherwise
+			int child(int i, bool right, bool create)
+			{
+				if (i < 0) return -1;
+
+				int c = right ? _cells[i].right : _cells[i].left;
+				if (c < 0 && create)
+				{
+					c = _cells.size();
+					_cells.push_back(Cell{ node_type(), -1, -1 });
+					(right ? _cells[i].right : _cells[i].left) = c;
+				}
+				return c;
+			}
+
+			// nodes intersecting [q.l, q.r]
+			int nodes(const Query& q) const
+			{
+				return count(0, _lo, _hi, q);
+			}
+		};
+
+		template<typename TNode>
+		struct Iter : public Pos
+		{
+			using node_type = TNode;
+			using tree_type = Tree<node_type>;
+
+			tree_type& tree;
+			// missing children are created on the way down, otherwise they are read as empty
+			bool create;
+
+			Iter(tree_type& tree, bool create) : Pos(0, tree.lo(), tree.hi()), tree(tree), create(create) {}
+			Iter(tree_type& tree, const Pos& p, bool create) : Pos(p), tree(tree), create(create) {}
+
+			Iter left() const { return Iter(tree, Pos(tree.child(i, false, create), l, m()), create); }
+			Iter right() const { return Iter(tree, Pos(tree.child(i, true, create), m() + 1, r), create); }
+
+			node_type& operator*() const { return tree.node(i); }
+			node_type* operator->() const { return &tree.node(i); }
+		};
+	}
+}
+
+
+// Range add and range sum over [lo, hi] of 64-bit coordinates, all values are 0 initially.
+// Updates create at most 8 nodes per level, queries create none.
+// For integral T the nodes keep adds and sums modulo 2^64, so a sum is exact whenever it fits
+// into T, even if the sums of larger ranges or the lengths times adds do not.
+template<typename T>
+class DynamicAddSumST
+{
+	using sum_type = typename std::conditional<std::is_integral<T>::value, uint64, T>::type;
+
+	struct Tag
+	{
+		sum_type add;
+		Tag() : add(0) {}
+	};
+
+	struct Node : public Tag
+	{
+		sum_type sum;
+		Node() : sum(0) {}
+	};
+
+	using iter = segment_tree::dynamic::Iter<Node>;
+	using query = segment_tree::dynamic::Query;
+	mutable segment_tree::dynamic::Tree<Node> _tree;
+	int _depth;
+	int _max_nodes;
+
+	struct calc_op
+	{
+		void push(const iter& it)
+		{
+			Node& node = *it;
+			if (node.add != 0)
+			{
+				segment_tree::modify_children(add_op(node.add), it);
+				node.sum += node.add * sum_type(it.len());
+				node.add = 0;
+			}
+		}
+	};
+
+	struct mod_op : public calc_op
+	{
+		void recalc(const iter& it)
+		{
+			it->sum = it.left()->sum + it.right()->sum;
+		}
+	};
+
+	struct add_op : public mod_op
+	{
+		sum_type val;
+		add_op(const sum_type& val) : val(val) {}
+
+		void modify(const iter& it)
+		{
+			it->add += val;
+		}
+	};
+
+	// tag is the sum of adds of the ancestors
+	struct sum_op
+	{
+		using result_type = sum_type;
+		sum_type zero() { return 0; }
+		sum_type get(const iter& it, const Tag& tag) { return it->sum + (it->add + tag.add) * sum_type(it.len()); }
+		Tag down(const iter& it, const Tag& tag) { Tag res; res.add = it->add + tag.add; return res; }
+		sum_type merge(sum_type left, sum_type right) { return left + right; }
+	};
+
+public:
+	// max_nodes caps the pool, updates that could pass it are refused
+	void assign(int64 lo, int64 hi, int max_nodes = INT_MAX)
+	{
+		_tree.assign(lo, hi);
+		_max_nodes = max_nodes;
+		_depth = 1;
+		for (uint64 len = uint64(hi - lo); len > 0; len >>= 1) ++_depth;
+	}
+
+	T sum(int64 l, int64 r) const
+	{
+		return T(segment_tree::calc_const(sum_op(), iter(_tree, false), query(l, r), Tag()));
+	}
+
+	// false if the update could pass max_nodes, nothing is changed then
+	bool add(int64 l, int64 r, T val)
+	{
+		if (int64(_tree.nodes()) + 8 * _depth > _max_nodes) return false;
+
+		segment_tree::modify(add_op(sum_type(val)), iter(_tree, true), query(l, r));
+		return true;
+	}
+
+	int nodes() const
+	{
+		return _tree.nodes();
+	}
+
+	// nodes intersecting [l, r]
+	int nodes(int64 l, int64 r) const
+	{
+		return _tree.nodes(query(l, r));
+	}
+
+	// bytes taken by the nodes
+	int64 memory() const
+	{
+		return int64(nodes()) * sizeof(typename segment_tree::dynamic::Tree<Node>::Cell);
+	}
+
+};
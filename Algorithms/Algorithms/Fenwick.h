@@ -1,6 +1,7 @@
 #pragma once
 #include "header.h"
 
+// Cell i of _t (1-based) keeps the sum of [i - (i & -i), i), the interface is 0-based.
 template <typename T>
 class Fenwik
 {
@@ -8,41 +9,74 @@ private:
 	vector<T> _t;
 
 public:
+	int size() const { return int(_t.size()) - 1; }
+
 	void assign(int size)
 	{
-		_t.assign(size, 0);
+		_t.assign(size + 1, 0);
 	}
 
 	void assign(int size, T val)
 	{
-		assign(size);
-		if (val == 0) return;
-		
-		for (int i = 0; i < size; ++i)
-		{
-			increment(i, val);
-		}		
+		assign(vector<T>(size, val));
 	}
 
+	// O(n): every cell is added into its parent i + (i & -i) once it is complete
 	void assign(const vector<T>& vals)
 	{
-		assign(vals.size());
-		for (int i = 0; i < vals.size(); ++i)
+		int n = vals.size();
+		_t.resize(n + 1);
+		_t[0] = 0;
+		copy(all(vals), _t.begin() + 1);
+		for (int i = 1; i <= n; ++i)
 		{
-			increment(i, vals[i]);
+			int j = i + (i & -i);
+			if (j <= n) _t[j] += _t[i];
 		}
 	}
 
 	void increment(int i, T val)
 	{
-		for (; i < _t.size(); i = (i | (i+1)))
+		for (++i; i < int(_t.size()); i += (i & -i))
 			_t[i] += val;
 	}
 
+	// Equal indices are merged first. Large batches go in one O(n) pass
+	// like assign, the others increment the merged updates one by one.
+	void increment_batch(vector<pair<int, T>> updates)
+	{
+		sort(all(updates), [](const pair<int, T>& a, const pair<int, T>& b) { return a.first < b.first; });
+		int k = 0;
+		for (const auto& u : updates)
+		{
+			if (k > 0 && updates[k-1].first == u.first) updates[k-1].second += u.second;
+			else updates[k++] = u;
+		}
+		updates.resize(k);
+
+		int n = size();
+		int depth = 1;
+		while ((1 << depth) < n) ++depth;
+		if (int64(k) * depth < n)
+		{
+			for (const auto& u : updates) increment(u.first, u.second);
+			return;
+		}
+
+		vector<T> delta(n + 1, 0);
+		for (const auto& u : updates) delta[u.first + 1] = u.second;
+		for (int i = 1; i <= n; ++i)
+		{
+			_t[i] += delta[i];
+			int j = i + (i & -i);
+			if (j <= n) delta[j] += delta[i];
+		}
+	}
+
 	T sum(int r) const
 	{
 		T res = 0;
-		for (; r >= 0; r = (r & (r+1)) - 1)
+		for (++r; r > 0; r -= (r & -r))
 			res += _t[r];
 		return res;
 	}
@@ -51,20 +85,211 @@ public:
 	{
 		return sum(r) - sum(l-1);
 	}
+
+	// Smallest i with sum(i) >= k, size() if none. Values must be non-negative.
+	// O(log n) descent: pos grows by the largest steps keeping sum(pos - 1) < k.
+	int lower_bound(T k) const
+	{
+		int n = size();
+		int step = 1;
+		while (step * 2 <= n) step *= 2;
+
+		int pos = 0;
+		for (; step > 0; step >>= 1)
+		{
+			if (pos + step <= n && _t[pos + step] < k)
+			{
+				pos += step;
+				k -= _t[pos];
+			}
+		}
+		return pos;
+	}
+};
+
+// Range increment and range sum: with the differences d of the values,
+// sum(r) = (r+1) * sum(d[i]) - sum(d[i] * i) over i <= r, one Fenwik for each sum.
+template <typename T>
+class RangeFenwik
+{
+private:
+	Fenwik<T> _d;
+	Fenwik<T> _di;
+
+	void increment_diff(int i, T val)
+	{
+		_d.increment(i, val);
+		_di.increment(i, val * i);
+	}
+
+public:
+	int size() const { return _d.size(); }
+
+	void assign(int size)
+	{
+		_d.assign(size);
+		_di.assign(size);
+	}
+
+	void assign(int size, T val)
+	{
+		assign(vector<T>(size, val));
+	}
+
+	// O(n)
+	void assign(const vector<T>& vals)
+	{
+		vector<T> d(vals.size()), di(vals.size());
+		forn(i, vals.size())
+		{
+			d[i] = vals[i] - (i > 0 ? vals[i-1] : 0);
+			di[i] = d[i] * i;
+		}
+		_d.assign(d);
+		_di.assign(di);
+	}
+
+	void increment(int l, int r, T val)
+	{
+		increment_diff(l, val);
+		increment_diff(r+1, -val);
+	}
+
+	void increment(int i, T val)
+	{
+		increment(i, i, val);
+	}
+
+	T sum(int r) const
+	{
+		return _d.sum(r) * (r+1) - _di.sum(r);
+	}
+
+	T sum(int l, int r) const
+	{
+		return sum(r) - sum(l-1);
+	}
 };
 
-//Finds first free place in segment of array of ones.
-/*
-	int FindFree(int l, int r)
+// Cell (i, j) of _t (1-based) keeps the sum of [i - (i & -i), i) x [j - (j & -j), j), one row after another.
+template <typename T>
+class Fenwik2D
+{
+private:
+	vector<T> _t;
+	int _n, _m;
+
+	T& cell(int i, int j) { return _t[size_t(i) * (_m + 1) + j]; }
+	const T& cell(int i, int j) const { return _t[size_t(i) * (_m + 1) + j]; }
+
+public:
+	int rows() const { return _n; }
+	int cols() const { return _m; }
+
+	void assign(int n, int m)
+	{
+		_n = n;
+		_m = m;
+		_t.assign(size_t(n + 1) * (m + 1), 0);
+	}
+
+	// O(nm): the parents in rows, then the parents in columns, as in Fenwik::assign
+	void assign(const vector<vector<T>>& vals)
 	{
-		while(l < r)
+		assign(vals.size(), vals.empty() ? 0 : vals[0].size());
+		forn(i, _n) forn(j, _m) cell(i+1, j+1) = vals[i][j];
+
+		for (int i = 1; i <= _n; ++i)
+		{
+			for (int j = 1; j <= _m; ++j)
+			{
+				int pj = j + (j & -j);
+				if (pj <= _m) cell(i, pj) += cell(i, j);
+			}
+		}
+		for (int i = 1; i <= _n; ++i)
 		{
-			int m = (l+r)/2;
-			if (Sum(l, m) >= m-l+1)
-				l = m + 1;
-			else
-				r = m;
+			int pi = i + (i & -i);
+			if (pi > _n) continue;
+			for (int j = 1; j <= _m; ++j) cell(pi, j) += cell(i, j);
 		}
-		return l;
 	}
-*/
\ No newline at end of file
+
+	// indices past the end are ignored
+	void increment(int x, int y, T val)
+	{
+		for (int i = x+1; i <= _n; i += (i & -i))
+			for (int j = y+1; j <= _m; j += (j & -j))
+				cell(i, j) += val;
+	}
+
+	// sum of [0, x] x [0, y]
+	T sum(int x, int y) const
+	{
+		T res = 0;
+		for (int i = x+1; i > 0; i -= (i & -i))
+			for (int j = y+1; j > 0; j -= (j & -j))
+				res += cell(i, j);
+		return res;
+	}
+
+	T sum(int x1, int y1, int x2, int y2) const
+	{
+		return sum(x2, y2) - sum(x1-1, y2) - sum(x2, y1-1) + sum(x1-1, y1-1);
+	}
+};
+
+// Rectangle increment and rectangle sum. With the differences d of the values,
+// sum(x, y) = sum(d[p][q] * (x-p+1) * (y-q+1)) over p <= x, q <= y,
+// so it keeps the sums of d, d*p, d*q and d*p*q.
+template <typename T>
+class RangeFenwik2D
+{
+private:
+	Fenwik2D<T> _d, _dp, _dq, _dpq;
+
+	void increment_diff(int p, int q, T val)
+	{
+		_d.increment(p, q, val);
+		_dp.increment(p, q, val * p);
+		_dq.increment(p, q, val * q);
+		_dpq.increment(p, q, val * p * q);
+	}
+
+public:
+	int rows() const { return _d.rows(); }
+	int cols() const { return _d.cols(); }
+
+	void assign(int n, int m)
+	{
+		_d.assign(n, m);
+		_dp.assign(n, m);
+		_dq.assign(n, m);
+		_dpq.assign(n, m);
+	}
+
+	void increment(int x1, int y1, int x2, int y2, T val)
+	{
+		increment_diff(x1, y1, val);
+		increment_diff(x1, y2+1, -val);
+		increment_diff(x2+1, y1, -val);
+		increment_diff(x2+1, y2+1, val);
+	}
+
+	void increment(int x, int y, T val)
+	{
+		increment(x, y, x, y, val);
+	}
+
+	// sum of [0, x] x [0, y]
+	T sum(int x, int y) const
+	{
+		if (x < 0 || y < 0) return 0;
+		return _d.sum(x, y) * (x+1) * (y+1) - _dp.sum(x, y) * (y+1) - _dq.sum(x, y) * (x+1) + _dpq.sum(x, y);
+	}
+
+	T sum(int x1, int y1, int x2, int y2) const
+	{
+		return sum(x2, y2) - sum(x1-1, y2) - sum(x2, y1-1) + sum(x1-1, y1-1);
+	}
+};
@@ -0,0 +1,117 @@
+#include "lca.h"
+#include "_tests.h"
+
+
+// Both O(1) RMQs against the leftmost min of a scan, on +-1 arrays of all small sizes
+// and past the point where blocks get longer than 1.
+void TestRmq1()
+{
+	mt19937 rnd(25);
+	for (int size : { 1, 2, 3, 4, 5, 7, 8, 16, 17, 100, 1000 })
+	{
+		vint a(size);
+		forn(i, size) a[i] = i ? a[i-1] + (rnd() % 2 ? 1 : -1) : 0;
+		SparseTable sparse;
+		sparse.Init(a);
+		PlusMinusOneRmq pm;
+		pm.Init(a);
+
+		forn(k, 2000)
+		{
+			int l = rnd() % size, r = rnd() % size;
+			if (l > r) swap(l, r);
+			int exp = int(min_element(a.begin() + l, a.begin() + r + 1) - a.begin());
+			test::assert_equal(exp, sparse.MinPos(l, r));
+			test::assert_equal(exp, pm.MinPos(l, r));
+		}
+	}
+}
+
+template<typename TLca>
+void CheckLca(const vector<Node>& g, mt19937& rnd)
+{
+	int n = g.size();
+	vint parent(n, -1), depth(n, 0), order{ 0 };
+	forn(k, order.size())
+	{
+		int v = order[k];
+		for (int to : g[v].to)
+		{
+			if (to == parent[v]) continue;
+			parent[to] = v;
+			depth[to] = depth[v] + 1;
+			order.push_back(to);
+		}
+	}
+
+	TLca lca;
+	lca.Init(g);
+	auto check = [&](int a, int b)
+	{
+		int x = a, y = b;
+		while (depth[x] > depth[y]) x = parent[x];
+		while (depth[y] > depth[x]) y = parent[y];
+		while (x != y)
+		{
+			x = parent[x];
+			y = parent[y];
+		}
+		test::assert_equal(x, lca.GetLca(a, b));
+	};
+
+	if (n <= 50)
+	{
+		forn(a, n) forn(b, n) check(a, b);
+		return;
+	}
+	forn(k, 3000) check(rnd() % n, rnd() % n);
+}
+
+template<typename TLca>
+void CheckLcaTrees()
+{
+	mt19937 rnd(25);
+	auto edge = [](vector<Node>& g, int a, int b)
+	{
+		g[a].to.push_back(b);
+		g[b].to.push_back(a);
+	};
+
+	for (int n : { 1, 2, 3, 10, 2000 })
+	{
+		// random, a node hangs from a uniform earlier one
+		vector<Node> g(n);
+		for (int i = 1; i < n; ++i) edge(g, rnd() % i, i);
+		CheckLca<TLca>(g, rnd);
+
+		// chain from the root, then with shuffled labels and the root inside
+		g.assign(n, Node());
+		for (int i = 1; i < n; ++i) edge(g, i - 1, i);
+		CheckLca<TLca>(g, rnd);
+
+		vint labels(n);
+		iota(all(labels), 0);
+		shuffle(all(labels), rnd);
+		g.assign(n, Node());
+		for (int i = 1; i < n; ++i) edge(g, labels[i - 1], labels[i]);
+		CheckLca<TLca>(g, rnd);
+
+		// star
+		g.assign(n, Node());
+		for (int i = 1; i < n; ++i) edge(g, 0, i);
+		CheckLca<TLca>(g, rnd);
+	}
+}
+
+void TestLca1()
+{
+	CheckLcaTrees<BasicLca<SegmentTree>>();
+	CheckLcaTrees<BasicLca<SparseTable>>();
+	CheckLcaTrees<BasicLca<PlusMinusOneRmq>>();
+}
+
+
+auto lcaTestsPub = tests::publish(
+	TestRmq1,
+	TestLca1
+);
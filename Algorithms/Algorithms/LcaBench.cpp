@@ -0,0 +1,51 @@
+#include "lca.h"
+#include "_bench.h"
+
+
+template<typename TLca>
+void BenchLcaOn(const string& name, const vector<Node>& g, const vector<pii>& qs)
+{
+	TLca lca;
+	double init = bench::measure([&]() { lca.Init(g); });
+	bench::report(name + ".init", g.size(), g.size(), init);
+
+	int64 acc = 0;
+	double seconds = bench::measure([&]()
+	{
+		for (const auto& q : qs) acc += lca.GetLca(q.first, q.second);
+	});
+	bench::consume(acc);
+	bench::report(name, g.size(), qs.size(), seconds);
+}
+
+// random trees, a node hangs from a uniform earlier one
+void BenchLca()
+{
+	static const int Queries = 10000000;
+	mt19937 rnd(42);
+	for (int size : { 1 << 16, 1 << 20 })
+	{
+		vector<Node> g(size);
+		for (int i = 1; i < size; ++i)
+		{
+			int p = rnd() % i;
+			g[p].to.push_back(i);
+			g[i].to.push_back(p);
+		}
+
+		vector<pii> qs(Queries);
+		for (auto& q : qs)
+		{
+			q.first = rnd() % size;
+			q.second = rnd() % size;
+		}
+
+		BenchLcaOn<BasicLca<SegmentTree>>("Lca.SegmentTree", g, qs);
+		BenchLcaOn<BasicLca<SparseTable>>("Lca.SparseTable", g, qs);
+		BenchLcaOn<BasicLca<PlusMinusOneRmq>>("Lca.PlusMinusOneRmq", g, qs);
+	}
+}
+
+auto lcaBenchPub = bench::publish(
+	BenchLca
+);
@@ -0,0 +1,299 @@
+#pragma once
+#include "SegmentTree.h"
+#include <memory>
+
+namespace segment_tree
+{
+	namespace persistent
+	{
+		// Nodes of all versions live in one arena, a version is the index of its root.
+		// Every operation gets a new stamp, a node is changed in place only by the operation
+		// that created it, other nodes are copied on the way down.
+		template<typename TNode>
+		class Tree
+		{
+		public:
+			using node_type = TNode;
+
+		private:
+			struct Cell
+			{
+				node_type node;
+				int left, right;
+				int stamp;
+			};
+
+			// Cells are allocated by bumping _count. Neither chunks nor the reserved directory
+			// ever move, so published versions can be read while the writer allocates.
+			static const int ChunkBits = 16;
+			static const int ChunkSize = 1 << ChunkBits;
+			static const int MaxChunks = 1 << 15;
+			vector<unique_ptr<Cell[]>> _chunks;
+			int _count = 0;
+			int _size = 0;
+			int _stamp = 0;
+
+			Cell& cell(int i) { return _chunks[i >> ChunkBits][i & (ChunkSize - 1)]; }
+
+			int alloc(const Cell& c)
+			{
+				if (_count == int64(_chunks.size()) * ChunkSize)
+				{
+					assert(_chunks.size() < MaxChunks);
+					_chunks.reserve(MaxChunks);
+					_chunks.emplace_back(new Cell[ChunkSize]);
+				}
+				cell(_count) = c;
+				return _count++;
+			}
+
+			int create(int l, int r, int stamp)
+			{
+				Cell c{ node_type(), -1, -1, stamp };
+				if (l != r)
+				{
+					int m = (l + r) >> 1;
+					c.left = create(l, m, stamp);
+					c.right = create(m + 1, r, stamp);
+				}
+				return alloc(c);
+			}
+
+			int copy_from(Tree& from, int i, vint& remap)
+			{
+				if (i < 0) return i;
+				if (remap[i] >= 0) return remap[i];
+
+				Cell c = from.cell(i);
+				c.left = copy_from(from, c.left, remap);
+				c.right = copy_from(from, c.right, remap);
+				return remap[i] = alloc(c);
+			}
+
+		public:
+			int size() const { return _size; }
+			// allocated nodes of all versions
+			int count() const { return _count; }
+			node_type& node(int i) { return cell(i).node; }
+
+			int next_stamp() { return ++_stamp; }
+
+			// root of a new tree with default nodes
+			int assign(int size, int stamp)
+			{
+				_chunks.clear();
+				_count = 0;
+				_size = size;
+				return create(0, size - 1, stamp);
+			}
+
+			int copy(int i, int stamp)
+			{
+				Cell c = cell(i);
+				c.stamp = stamp;
+				return alloc(c);
+			}
+
+			// child of i, copied first if it is written (stamp != 0) and not owned by the stamp
+			int child(int i, bool right, int stamp)
+			{
+				int& c = right ? cell(i).right : cell(i).left;
+				if (stamp != 0 && cell(c).stamp != stamp) c = copy(c, stamp);
+				return c;
+			}
+
+			// Forgets all versions and copies roots from another tree,
+			// roots are replaced by their new indices.
+			void assign(Tree& from, vint& roots)
+			{
+				_chunks.clear();
+				_count = 0;
+				_size = from._size;
+				_stamp = from._stamp;
+
+				vint remap(from._count, -1);
+				for (int& root : roots)
+				{
+					root = copy_from(from, root, remap);
+				}
+			}
+
+			// Releases all versions except roots, which are replaced by their new indices.
+			void compact(vint& roots)
+			{
+				Tree res;
+				res.assign(*this, roots);
+				*this = std::move(res);
+			}
+		};
+
+		template<typename TNode>
+		struct Iter : public Pos
+		{
+			using node_type = TNode;
+			using tree_type = Tree<node_type>;
+
+			tree_type& tree;
+			// 0 for read only iteration
+			int stamp;
+
+			Iter(tree_type& tree, int root, int stamp) : Pos(root, 0, tree.size() - 1), tree(tree), stamp(stamp) {}
+			Iter(tree_type& tree, const Pos& p, int stamp) : Pos(p), tree(tree), stamp(stamp) {}
+
+			Iter left() const { return Iter(tree, Pos(tree.child(i, false, stamp), l, m()), stamp); }
+			Iter right() const { return Iter(tree, Pos(tree.child(i, true, stamp), m() + 1, r), stamp); }
+
+			node_type& operator*() const { return tree.node(i); }
+			node_type* operator->() const { return &tree.node(i); }
+		};
+
+		// op.init(it), op.recalc(it)
+		// returns the root of the first version
+		template<typename TOperation, typename TNode>
+		int build(TOperation& op, Tree<TNode>& tree, int size)
+		{
+			int stamp = tree.next_stamp();
+			int root = tree.assign(size, stamp);
+			segment_tree::build(op, Iter<TNode>(tree, root, stamp));
+			return root;
+		}
+
+		// op.zero(), op.get(it, tag), op.down(it, tag), op.merge(r1, r2)
+		// Reads never push: delayed modifications are folded in by calc_const and the stamp 0
+		// iterator copies nothing, so published versions and the arena stay untouched.
+		template<typename TOperation, typename TNode, typename TTag>
+		typename TOperation::result_type calc(TOperation& op, Tree<TNode>& tree, int root, const Query& q, const TTag& tag)
+		{
+			return segment_tree::calc_const(op, Iter<TNode>(tree, root, 0), q, tag);
+		}
+
+		// op.push(it), op.modify(it), op.recalc(it)
+		// returns the root of the new version, root stays unchanged
+		template<typename TOperation, typename TNode>
+		int modify(TOperation& op, Tree<TNode>& tree, int root, const Query& q)
+		{
+			int stamp = tree.next_stamp();
+			int res = tree.copy(root, stamp);
+			segment_tree::modify(op, Iter<TNode>(tree, res, stamp), q);
+			return res;
+		}
+	}
+}
+
+
+template<typename T>
+class PersistentAddSumST
+{
+	struct Node
+	{
+		T sum;
+		T add;
+		Node() : sum(0), add(0) {}
+	};
+
+	using iter = segment_tree::persistent::Iter<Node>;
+	mutable segment_tree::persistent::Tree<Node> _tree;
+
+	struct calc_op
+	{
+		void push(const iter& it)
+		{
+			Node& node = *it;
+			if (node.add != 0)
+			{
+				segment_tree::modify_children(add_op(node.add), it);
+				node.sum += node.add * it.len();
+				node.add = 0;
+			}
+		}
+	};
+
+	struct mod_op : public calc_op
+	{
+		void recalc(const iter& it)
+		{
+			it->sum = it.left()->sum + it.right()->sum;
+		}
+	};
+
+	struct init_vec_op : public mod_op
+	{
+		const vector<T>& v;
+		init_vec_op(const vector<T>& v) : v(v) {}
+
+		void init(const iter& it)
+		{
+			it->sum = v[it.leaf_index()];
+		}
+	};
+
+	struct init_const_op : public mod_op
+	{
+		T val;
+		init_const_op(const T& val) : val(val) {}
+
+		void init(const iter& it)
+		{
+			it->sum = val;
+		}
+	};
+
+	struct add_op : public mod_op
+	{
+		T val;
+		add_op(const T& val) : val(val) {}
+
+		void modify(const iter& it)
+		{
+			it->add += val;
+		}
+	};
+
+	// tag is the sum of adds of the ancestors, the add of a node is not in its sum yet
+	struct sum_op
+	{
+		using result_type = T;
+		T zero() { return 0; }
+		T get(const iter& it, T add) { return it->sum + (it->add + add) * it.len(); }
+		T down(const iter& it, T add) { return it->add + add; }
+		T merge(T left, T right) { return left + right; }
+	};
+
+public:
+	// index of the root in the shared arena
+	using version = int;
+
+	// Forgets all versions, returns the first one.
+	version assign(int size, const T& val = 0)
+	{
+		return segment_tree::persistent::build(init_const_op(val), _tree, size);
+	}
+	version assign(const vector<T>& vals)
+	{
+		return segment_tree::persistent::build(init_vec_op(vals), _tree, vals.size());
+	}
+
+	T sum(version v, int l, int r) const
+	{
+		return segment_tree::persistent::calc(sum_op(), _tree, v, segment_tree::Query(l, r), T(0));
+	}
+
+	// returns the new version, v stays available
+	version add(version v, int l, int r, T val)
+	{
+		return segment_tree::persistent::modify(add_op(val), _tree, v, segment_tree::Query(l, r));
+	}
+
+	// Releases all versions except keep, which are replaced by their new handles.
+	void release(vector<version>& keep)
+	{
+		_tree.compact(keep);
+	}
+
+	// nodes allocated for all live versions
+	int nodes() const
+	{
+		return _tree.count();
+	}
+
+};
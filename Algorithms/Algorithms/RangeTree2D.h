@@ -0,0 +1,326 @@
+#pragma once
+#include "header.h"
+
+// Rectangle count and sum over weighted points, O(log^2 n) or better per query.
+// Nodes of both structures are ranges of flat arrays, no per node vectors.
+namespace range_tree_2d
+{
+	// Weighted point, sorted by x and then by y.
+	template<typename T, typename TWeight>
+	struct Point
+	{
+		T x, y;
+		TWeight w;
+	};
+
+	template<typename T, typename TWeight>
+	void sort_points(const vector<pair<T, T>>& points, const vector<TWeight>& weights,
+		vector<Point<T, TWeight>>& res)
+	{
+		res.resize(points.size());
+		forn(i, points.size())
+		{
+			res[i].x = points[i].first;
+			res[i].y = points[i].second;
+			res[i].w = weights[i];
+		}
+		sort(all(res), [](const Point<T, TWeight>& a, const Point<T, TWeight>& b)
+		{
+			return a.x < b.x || (a.x == b.x && a.y < b.y);
+		});
+	}
+}
+
+
+// Static merge-sort tree over points sorted by x with fractional cascading:
+// one binary search at the root, then O(1) per visited node, O(log n) per query.
+// Level k keeps every node of depth k sorted by y at the positions [l, r] of its points,
+// left and cum are prefix counters over the whole level, so a node reads them at l and l + j.
+template<typename T, typename TWeight = int64>
+class MergeSortTree
+{
+	struct Entry
+	{
+		T y;
+		// points of [0, p) of the level going to the left child of their node
+		int left;
+		// weight of [0, p) of the level
+		TWeight cum;
+	};
+
+	using point_type = range_tree_2d::Point<T, TWeight>;
+
+	vector<Entry> _t;
+	vector<T> _xs;
+	int _size;
+	int _levels;
+
+	Entry* level(int k) { return _t.data() + size_t(k) * (_size + 1); }
+	const Entry* level(int k) const { return _t.data() + size_t(k) * (_size + 1); }
+
+	void build(const vector<point_type>& ps, int k, int l, int r)
+	{
+		Entry* e = level(k);
+		if (l == r)
+		{
+			e[l].y = ps[l].y;
+			e[l].cum = ps[l].w;
+			e[l].left = 0;
+			return;
+		}
+
+		int m = (l + r) >> 1;
+		build(ps, k + 1, l, m);
+		build(ps, k + 1, m + 1, r);
+
+		// stable merge, the children keep their weight in cum until the prefix pass
+		const Entry* c = level(k + 1);
+		int i = l, j = m + 1;
+		for (int p = l; p <= r; ++p)
+		{
+			bool fromLeft = j > r || (i <= m && c[i].y <= c[j].y);
+			const Entry& from = c[fromLeft ? i++ : j++];
+			e[p].y = from.y;
+			e[p].cum = from.cum;
+			e[p].left = fromLeft;
+		}
+	}
+
+	// turns per position values of left and cum into prefix counters
+	void prefix()
+	{
+		forn(k, _levels)
+		{
+			Entry* e = level(k);
+			int left = 0;
+			TWeight cum = 0;
+			for (int p = 0; p <= _size; ++p)
+			{
+				int l = (p < _size ? e[p].left : 0);
+				TWeight c = (p < _size ? e[p].cum : 0);
+				e[p].left = left;
+				e[p].cum = cum;
+				left += l;
+				cum += c;
+			}
+		}
+	}
+
+	// the points of [a, b] among [lo, hi) of node [l, r] of level k by y
+	void calc(int k, int l, int r, int lo, int hi, int a, int b, int64& cnt, TWeight& sum) const
+	{
+		if (lo >= hi || r < a || l > b) return;
+
+		const Entry* e = level(k);
+		if (a <= l && r <= b)
+		{
+			cnt += hi - lo;
+			sum += e[l + hi].cum - e[l + lo].cum;
+			return;
+		}
+
+		int m = (l + r) >> 1;
+		int llo = e[l + lo].left - e[l].left;
+		int lhi = e[l + hi].left - e[l].left;
+		calc(k + 1, l, m, llo, lhi, a, b, cnt, sum);
+		calc(k + 1, m + 1, r, lo - llo, hi - lhi, a, b, cnt, sum);
+	}
+
+	void assign(const vector<point_type>& ps)
+	{
+		_size = ps.size();
+		_levels = 1;
+		while ((1 << (_levels - 1)) < _size) ++_levels;
+
+		_t.assign(size_t(_levels) * (_size + 1), Entry());
+		_xs.resize(_size);
+		forn(i, _size) _xs[i] = ps[i].x;
+
+		if (_size > 0) build(ps, 0, 0, _size - 1);
+		prefix();
+	}
+
+	void calc(T x1, T y1, T x2, T y2, int64& cnt, TWeight& sum) const
+	{
+		cnt = 0;
+		sum = 0;
+		if (_size == 0 || x1 > x2 || y1 > y2) return;
+
+		int a = lower_bound(all(_xs), x1) - _xs.begin();
+		int b = int(upper_bound(all(_xs), x2) - _xs.begin()) - 1;
+		if (a > b) return;
+
+		const Entry* e = level(0);
+		auto less = [](const Entry& entry, const T& y) { return entry.y < y; };
+		auto greater = [](const T& y, const Entry& entry) { return y < entry.y; };
+		int lo = lower_bound(e, e + _size, y1, less) - e;
+		int hi = upper_bound(e, e + _size, y2, greater) - e;
+		calc(0, 0, _size - 1, lo, hi, a, b, cnt, sum);
+	}
+
+public:
+	void assign(const vector<pair<T, T>>& points, const vector<TWeight>& weights)
+	{
+		vector<point_type> ps;
+		range_tree_2d::sort_points(points, weights, ps);
+		assign(ps);
+	}
+	void assign(const vector<pair<T, T>>& points)
+	{
+		assign(points, vector<TWeight>(points.size(), 1));
+	}
+
+	// points in [x1, x2] x [y1, y2]
+	int64 count(T x1, T y1, T x2, T y2) const
+	{
+		int64 cnt;
+		TWeight sum;
+		calc(x1, y1, x2, y2, cnt, sum);
+		return cnt;
+	}
+
+	// weight of the points in [x1, x2] x [y1, y2]
+	TWeight sum(T x1, T y1, T x2, T y2) const
+	{
+		int64 cnt;
+		TWeight sum;
+		calc(x1, y1, x2, y2, cnt, sum);
+		return sum;
+	}
+};
+
+
+// Offline 2D Fenwik: the points are known in advance, their weights change.
+// Fenwik node i over x indices keeps a Fenwik over the sorted y of its points,
+// all of them in one array at _start[i], O(log^2 n) per operation.
+template<typename T, typename TWeight = int64>
+class OfflineFenwik2D
+{
+	vector<T> _xs;
+	vint _start;
+	vector<T> _ys;
+	vector<TWeight> _t;
+
+	int x_count() const { return _xs.size(); }
+	int x_index(T x) const { return lower_bound(all(_xs), x) - _xs.begin(); }
+
+	// position of y in Fenwik node xi
+	int y_index(int xi, T y) const
+	{
+		const T* ys = _ys.data() + _start[xi];
+		return lower_bound(ys, _ys.data() + _start[xi + 1], y) - ys;
+	}
+
+	// prefix sum of the first cnt values of Fenwik node xi
+	TWeight prefix(int xi, int cnt) const
+	{
+		TWeight res = 0;
+		const TWeight* t = _t.data() + _start[xi];
+		for (int r = cnt - 1; r >= 0; r = (r & (r + 1)) - 1)
+			res += t[r];
+		return res;
+	}
+
+	// sum over x indices [0, xi] and y in [y1, y2]
+	TWeight sum(int xi, T y1, T y2) const
+	{
+		TWeight res = 0;
+		for (; xi >= 0; xi = (xi & (xi + 1)) - 1)
+		{
+			const T* first = _ys.data() + _start[xi];
+			const T* last = _ys.data() + _start[xi + 1];
+			res += prefix(xi, upper_bound(first, last, y2) - first) - prefix(xi, lower_bound(first, last, y1) - first);
+		}
+		return res;
+	}
+
+public:
+	// points may repeat, weights start at zero
+	void assign(const vector<pair<T, T>>& points)
+	{
+		_xs.resize(points.size());
+		forn(i, points.size()) _xs[i] = points[i].first;
+		sort(all(_xs));
+		_xs.erase(unique(all(_xs)), _xs.end());
+
+		// y of every point goes to all Fenwik nodes covering its x index,
+		// in the order of y, so the nodes come out sorted without per node sorts
+		vector<pair<T, int>> byY(points.size());
+		forn(i, points.size()) byY[i] = make_pair(points[i].second, x_index(points[i].first));
+		sort(all(byY));
+
+		_start.assign(x_count() + 1, 0);
+		for (const auto& p : byY)
+		{
+			for (int xi = p.second; xi < x_count(); xi = (xi | (xi + 1)))
+				++_start[xi + 1];
+		}
+		forn(i, x_count()) _start[i + 1] += _start[i];
+
+		vint end(_start.begin(), _start.end() - 1);
+		_ys.resize(_start.back());
+		for (const auto& p : byY)
+		{
+			for (int xi = p.second; xi < x_count(); xi = (xi | (xi + 1)))
+			{
+				if (end[xi] == _start[xi] || _ys[end[xi] - 1] < p.first) _ys[end[xi]++] = p.first;
+			}
+		}
+
+		// drop the room left by repeated y
+		int total = 0;
+		forn(xi, x_count())
+		{
+			int from = _start[xi];
+			_start[xi] = total;
+			for (int k = from; k < end[xi]; ++k) _ys[total++] = _ys[k];
+		}
+		_start[x_count()] = total;
+		_ys.resize(total);
+		_t.assign(total, 0);
+	}
+	void assign(const vector<pair<T, T>>& points, const vector<TWeight>& weights)
+	{
+		assign(points);
+
+		// weights at their positions, then every Fenwik node is built in linear time
+		forn(i, points.size())
+		{
+			for (int xi = x_index(points[i].first); xi < x_count(); xi = (xi | (xi + 1)))
+				_t[_start[xi] + y_index(xi, points[i].second)] += weights[i];
+		}
+		forn(xi, x_count())
+		{
+			TWeight* t = _t.data() + _start[xi];
+			int n = _start[xi + 1] - _start[xi];
+			forn(i, n)
+			{
+				int j = (i | (i + 1));
+				if (j < n) t[j] += t[i];
+			}
+		}
+	}
+
+	// (x, y) must be one of the points
+	void increment(T x, T y, TWeight val)
+	{
+		for (int xi = x_index(x); xi < x_count(); xi = (xi | (xi + 1)))
+		{
+			int n = _start[xi + 1] - _start[xi];
+			int i = y_index(xi, y);
+			TWeight* t = _t.data() + _start[xi];
+			for (; i < n; i = (i | (i + 1)))
+				t[i] += val;
+		}
+	}
+
+	// weight of the points in [x1, x2] x [y1, y2]
+	TWeight sum(T x1, T y1, T x2, T y2) const
+	{
+		if (x1 > x2 || y1 > y2) return 0;
+
+		int a = x_index(x1) - 1;
+		int b = int(upper_bound(all(_xs), x2) - _xs.begin()) - 1;
+		return sum(b, y1, y2) - sum(a, y1, y2);
+	}
+};
@@ -1,40 +1,16 @@
 #include "SegmentTree.h"
+#include "WideSegmentTree.h"
+#include "PersistentSegmentTree.h"
+#include "ConcurrentSegmentTree.h"
+#include "DynamicSegmentTree.h"
+#include "RangeTree2D.h"
+#include "Fenwick.h"
+#include "BlockedFenwick.h"
+#include "ConcurrentFenwick.h"
+#include "AwesomeArray.h"
 #include "_tests.h"
 
 
-template<typename T, T INF = T(1e9)>
-class AwesomeArray
-{
-	vector<T> _v;
-
-public:
-	void assign(int size) { _v.assign(size, T{}); }
-	void assign(int size, const T& value) { _v.assign(size, value); }
-	void assign(const vector<T>& v) { _v = v; }
-
-	void add(int l, int r, T val)
-	{
-		for (int i = l; i <= r; ++i) _v[i] += val;
-	}
-	void set(int l, int r, T val)
-	{
-		for (int i = l; i <= r; ++i) _v[i] = val;
-	}
-	T sum(int l, int r)
-	{
-		T res = T{};
-		for (int i = l; i <= r; ++i) res += _v[i];
-		return res;
-	}
-	pair<T, int> min(int l, int r)
-	{
-		auto res = pair<T, int>(INF, -1);
-		for (int i = l; i <= r; ++i) res = std::min(res, make_pair(_v[i], i));
-		return res;
-	}
-};
-
-
 template<typename TExpected, typename TActual>
 class AwesomeArrayTest
 {
@@ -60,6 +36,13 @@ public:
 		_act.assign(v);
 	}
 
+	template<typename TIterator>
+	void assign_range(int l, int r, TIterator first)
+	{
+		_exp.assign_range(l, r, first);
+		_act.assign_range(l, r, first);
+	}
+
 	template<typename T>
 	void add(int l, int r, T val)
 	{
@@ -74,6 +57,34 @@ public:
 		_act.set(l, r, val);
 	}
 
+	template<typename T>
+	void chmin(int l, int r, T val)
+	{
+		_exp.chmin(l, r, val);
+		_act.chmin(l, r, val);
+	}
+
+	template<typename T>
+	void chmax(int l, int r, T val)
+	{
+		_exp.chmax(l, r, val);
+		_act.chmax(l, r, val);
+	}
+
+	template<typename T>
+	void add(int i, T val)
+	{
+		_exp.add(i, val);
+		_act.add(i, val);
+	}
+
+	template<typename T>
+	void set(int i, T val)
+	{
+		_exp.set(i, val);
+		_act.set(i, val);
+	}
+
 	void sum(int l, int r)
 	{
 		auto exp = _exp.sum(l, r);
@@ -119,7 +130,776 @@ void TestSegmentTree2()
 	t.min(1, 100);
 }
 
+void TestSegmentTree3()
+{
+	AwesomeArrayTest<AwesomeArray<int>, SumST<int>> t;
+
+	vint v{ 1, 2, 3 };
+	t.assign(v);
+	t.sum(0, 2);
+	t.assign(101);
+
+	t.add(1, 100);
+	t.set(50, 7);
+	t.add(100, -3);
+
+	t.sum(1, 100);
+	t.sum(0, 49);
+	t.sum(50, 50);
+	t.sum(51, 100);
+}
+
+void TestSegmentTree4()
+{
+	static const int INF = 1e9;
+	AwesomeArrayTest<AwesomeArray<int, INF>, MinST<int, INF>> t;
+
+	vint v{ 3, 2, 1 };
+	t.assign(v);
+	t.min(0, 1);
+	t.assign(101, 2);
+
+	t.add(1, -1);
+	t.set(70, -5);
+	t.set(99, -5);
+
+	t.min(0, 100);
+	t.min(2, 69);
+	t.min(71, 100);
+	t.min(1, 1);
+}
+
+void TestSegmentTree5()
+{
+	using segment_tree::Query;
+	AwesomeArray<int> exp;
+	AddSetSumST<int> act;
+	AddMinST<int> actMin;
+
+	exp.assign(101);
+	act.assign(101);
+	actMin.assign(101);
+
+	exp.add(1, 50, 100);
+	act.add(1, 50, 100);
+	actMin.add(1, 50, 100);
+	exp.set(10, 70, 50);
+	act.set(10, 70, 50);
+	actMin.add(10, 70, -50);
+	actMin.add(51, 70, 100);
+
+	vector<Query> qs{ Query(1, 100), Query(0, 0), Query(10, 70), Query(5, 60), Query(5, 60), Query(60, 100), Query(50, 51) };
+	vint res;
+	vector<pii> resMin;
+	act.sum_batch(qs, res);
+	actMin.min_batch(qs, resMin);
+
+	forn(i, qs.size())
+	{
+		test::assert_equal(exp.sum(qs[i].l, qs[i].r), res[i]);
+		test::assert_equal(exp.min(qs[i].l, qs[i].r), resMin[i]);
+	}
+}
+
+void TestSegmentTree6()
+{
+	AwesomeArrayTest<AwesomeArray<int>, WideSumST<int>> t;
+
+	vint v{ 1, 2, 3 };
+	t.assign(v);
+	t.sum(0, 2);
+	t.assign(1001);
+
+	t.add(1, 100);
+	t.set(500, 7);
+	t.add(1000, -3);
+
+	t.sum(1, 1000);
+	t.sum(0, 499);
+	t.sum(500, 500);
+	t.sum(17, 950);
+}
+
+void TestSegmentTree7()
+{
+	static const int INF = 1e9;
+	AwesomeArrayTest<AwesomeArray<int, INF>, WideMinST<int, INF>> t;
+
+	vint v{ 3, 2, 1 };
+	t.assign(v);
+	t.min(0, 1);
+	t.assign(1001, 2);
+
+	t.add(1, -1);
+	t.set(700, -5);
+	t.set(999, -5);
+
+	t.min(0, 1000);
+	t.min(2, 699);
+	t.min(701, 1000);
+	t.min(1, 1);
+	t.min(15, 16);
+}
+
+void TestSegmentTree8()
+{
+	AwesomeArray<int> exp0, exp1, exp2;
+	PersistentAddSumST<int> act;
+
+	exp0.assign(101, 1);
+	vector<int> v{ act.assign(101, 1) };
+
+	exp1 = exp0;
+	exp1.add(1, 50, 100);
+	v.push_back(act.add(v[0], 1, 50, 100));
+
+	exp2 = exp0;
+	exp2.add(10, 70, 50);
+	v.push_back(act.add(v[0], 10, 70, 50));
+
+	int nodes = act.nodes();
+	test::assert_equal(exp0.sum(0, 100), act.sum(v[0], 0, 100));
+	test::assert_equal(exp1.sum(5, 60), act.sum(v[1], 5, 60));
+	test::assert_equal(exp2.sum(5, 60), act.sum(v[2], 5, 60));
+	test::assert_equal(exp1.sum(5, 60), act.sum(v[1], 5, 60));
+	test::assert_equal(nodes, act.nodes());
+
+	v.erase(v.begin());
+	act.release(v);
+
+	test::assert_equal(exp1.sum(40, 100), act.sum(v[0], 40, 100));
+	test::assert_equal(exp2.sum(0, 10), act.sum(v[1], 0, 10));
+}
+
+void TestSegmentTree9()
+{
+	AwesomeArrayTest<AwesomeArray<int>, ConcurrentAddSetSumST<int>> t;
+
+	vint v{ 1, 2, 3 };
+	t.assign(v);
+	t.assign(101);
+
+	t.add(1, 50, 100);
+	t.set(10, 70, 50);
+	t.add(5, 20, 3);
+
+	t.sum(1, 100);
+	t.sum(15, 60);
+}
+
+void TestSegmentTree10()
+{
+	static const int INF = 1e9;
+	AwesomeArrayTest<AwesomeArray<int, INF>, ConcurrentAddMinST<int, INF>> t;
+
+	vint v{ 1, 2, 3 };
+	t.assign(v);
+	t.assign(101, 2);
+
+	t.add(1, 50, 100);
+	t.add(10, 70, 50);
+
+	t.min(1, 100);
+	t.min(5, 60);
+}
+
+void TestSegmentTree11()
+{
+	AwesomeArrayTest<AwesomeArray<int>, AddSetSumST<int>> t;
+	t.assign(101);
+
+	vint v{ 5, 6, 7, 8, 9, 10 };
+	t.add(1, 50, 100);
+	t.set(10, 70, 50);
+	t.assign_range(45, 50, v.begin());
+	t.assign_range(0, 0, v.begin());
+
+	t.sum(1, 100);
+	t.sum(44, 47);
+	t.sum(0, 0);
+}
+
+void TestSegmentTree12()
+{
+	static const int INF = 1e9;
+	AwesomeArrayTest<AwesomeArray<int, INF>, AddMinST<int, INF>> t;
+	t.assign(101, 2);
+
+	vint v{ 5, -6, 7, -8, 9, 10 };
+	t.add(1, 50, 100);
+	t.assign_range(45, 50, v.begin());
+	t.add(10, 70, 50);
+
+	t.min(1, 100);
+	t.min(44, 46);
+	t.min(51, 100);
+}
+
+void TestSegmentTree13()
+{
+	vint v{ 1, 0, 2, 0, 0, 3, 1 };
+	AddSumST<int> sum;
+	AddSetSumST<int> setSum;
+	AddMinST<int> min;
+	sum.assign(v);
+	setSum.assign(v);
+	min.assign(v);
+
+	test::assert_equal(0, sum.find_prefix_at_least(1));
+	test::assert_equal(2, sum.find_prefix_at_least(2));
+	test::assert_equal(5, setSum.find_prefix_at_least(4));
+	test::assert_equal(-1, setSum.find_prefix_at_least(8));
+
+	sum.add(1, 4, 1);
+	setSum.set(0, 3, 0);
+	test::assert_equal(1, sum.find_prefix_at_least(2));
+	test::assert_equal(4, sum.find_first(3, [](int s) { return s >= 2; }));
+	test::assert_equal(5, setSum.find_prefix_at_least(1));
+
+	test::assert_equal(3, min.find_first_at_most(2, 0));
+	min.add(0, 4, 5);
+	test::assert_equal(6, min.find_first_at_most(0, 1));
+	test::assert_equal(-1, min.find_first_at_most(0, 0));
+}
+
+void TestSegmentTree14()
+{
+	const int64 base = 1ll << 40;
+	AwesomeArray<int64> exp;
+	DynamicAddSumST<int64> act;
+	exp.assign(101);
+	act.assign(base, base + 100);
+
+	exp.add(1, 50, 100);
+	act.add(base + 1, base + 50, 100);
+	exp.add(10, 70, 50);
+	act.add(base + 10, base + 70, 50);
+
+	test::assert_equal(exp.sum(1, 100), act.sum(base + 1, base + 100));
+	test::assert_equal(exp.sum(5, 60), act.sum(base + 5, base + 60));
+	test::assert_equal(exp.sum(71, 100), act.sum(base + 71, base + 100));
+
+	// the sums of the large nodes pass LLONG_MAX, the queried ones fit
+	DynamicAddSumST<int64> wide;
+	wide.assign(0, LLONG_MAX - 1);
+	wide.add(1ll << 62, 1ll << 62, 3);
+	wide.add(0, LLONG_MAX - 1, 1);
+	test::assert_equal(int64(3 + (1ll << 20)), wide.sum((1ll << 62) - (1ll << 19), (1ll << 62) + (1ll << 19) - 1));
+	wide.add(0, LLONG_MAX - 1, -2);
+	test::assert_equal(int64(3 - (1ll << 20)), wide.sum((1ll << 62) - (1ll << 19), (1ll << 62) + (1ll << 19) - 1));
+	test::assert_equal(int64(-3), wide.sum(LLONG_MAX - 3, LLONG_MAX - 1));
+
+	DynamicAddSumST<int> capped;
+	capped.assign(0, 1000, 100);
+	test::assert_bool(capped.add(1, 1, 1));
+	test::assert_bool(!capped.add(2, 2, 1));
+}
+
+void TestSegmentTree15()
+{
+	using segment_tree::dfs_layout;
+	static const int INF = 1e9;
+	AwesomeArrayTest<AwesomeArray<int>, AddSetSumST<int, dfs_layout>> t;
+	AwesomeArrayTest<AwesomeArray<int, INF>, AddMinST<int, INF, dfs_layout>> tmin;
+
+	vint v{ 1, 2, 3 };
+	t.assign(v);
+	t.assign(101);
+	tmin.assign(v);
+	tmin.assign(101, 2);
+
+	t.add(1, 50, 100);
+	t.set(10, 70, 50);
+	tmin.add(1, 50, 100);
+	tmin.add(10, 70, 50);
+
+	t.sum(1, 100);
+	t.sum(33, 77);
+	tmin.min(1, 100);
+	tmin.min(33, 77);
+}
+
+void TestSegmentTree16()
+{
+	static const int INF = 1e9;
+	AwesomeArrayTest<AwesomeArray<int>, NoPushAddSumST<int>> t;
+	AwesomeArrayTest<AwesomeArray<int, INF>, NoPushAddMinST<int, INF>> tmin;
+
+	vint v{ 1, 2, 3 };
+	t.assign(v);
+	t.assign(101);
+	tmin.assign(v);
+	tmin.assign(101, 2);
+
+	t.add(1, 50, 100);
+	t.add(10, 70, -50);
+	tmin.add(1, 50, 100);
+	tmin.add(10, 70, -50);
+
+	t.sum(1, 100);
+	t.sum(33, 77);
+	tmin.min(1, 100);
+	tmin.min(33, 77);
+}
+
+void TestSegmentTree17()
+{
+	static const int INF = 1e9;
+	AwesomeArrayTest<AwesomeArray<int>, ChminChmaxAddSumST<int, INF>> t;
+
+	vint v{ 1, 2, 3 };
+	t.assign(v);
+	t.chmin(0, 2, 2);
+	t.sum(0, 2);
+	t.assign(101, 5);
+
+	t.add(1, 50, 100);
+	t.chmin(10, 70, 60);
+	t.sum(1, 100);
+	t.chmax(30, 90, 40);
+	t.add(0, 45, -20);
+	t.sum(33, 77);
+	t.chmin(0, 100, 30);
+	t.chmax(20, 60, 35);
+	t.sum(0, 100);
+	t.sum(25, 55);
+}
+
+void TestSegmentTree18()
+{
+	vector<pii> points{ { 1, 1 }, { 2, 5 }, { 2, 5 }, { 3, -2 }, { 5, 4 }, { 7, 7 }, { -1, 3 }, { 4, 4 } };
+	vint64 weights{ 1, 2, 3, 4, 5, 6, 7, 8 };
+	MergeSortTree<int> mst;
+	mst.assign(points, weights);
+	OfflineFenwik2D<int> bit;
+	bit.assign(points, weights);
+
+	auto check = [&](int x1, int y1, int x2, int y2)
+	{
+		int64 cnt = 0, sum = 0;
+		forn(i, points.size())
+		{
+			if (points[i].first < x1 || points[i].first > x2 || points[i].second < y1 || points[i].second > y2) continue;
+			++cnt;
+			sum += weights[i];
+		}
+		test::assert_equal(cnt, mst.count(x1, y1, x2, y2));
+		test::assert_equal(sum, mst.sum(x1, y1, x2, y2));
+		test::assert_equal(sum, bit.sum(x1, y1, x2, y2));
+	};
+
+	check(-10, -10, 10, 10);
+	check(2, 4, 5, 5);
+	check(0, 0, 3, 10);
+	check(6, 0, 6, 10);
+
+	bit.increment(2, 5, 10);
+	test::assert_equal(int64(1 + 12 + 3 + 8), bit.sum(1, 1, 4, 5));
+}
+
+// One writer adds 1 to the elements in turn, so after k adds the first minimum is at
+// (k / Size, k % Size). Readers check that the versions they see only move forward.
+void TestSegmentTree19()
+{
+	static const int Size = 1000;
+	static const int Adds = 200000;
+	static const int Readers = 3;
+	ConcurrentAddMinST<int> min;
+	ConcurrentAddSetSumST<int64> sum;
+	min.assign(Size, 0);
+	sum.assign(Size);
+
+	atomic<bool> done(false);
+	vector<std::thread> readers;
+	forn(k, Readers)
+	{
+		readers.emplace_back([&]()
+		{
+			int64 lastSum = 0;
+			int last = 0;
+			while (!done.load())
+			{
+				pii res = min.min(0, Size - 1);
+				int version = res.first * Size + res.second;
+				if (res.second < 0 || res.second >= Size || version < last || version > Adds) test::fail("inconsistent version ", res);
+				last = version;
+
+				int64 s = sum.sum(0, Size - 1);
+				if (s < lastSum || s > Adds) test::fail("inconsistent sum ", s);
+				lastSum = s;
+			}
+		});
+	}
+
+	forn(i, Adds)
+	{
+		min.add(i % Size, i % Size, 1);
+		sum.add(i % Size, i % Size, 1);
+	}
+	done = true;
+	for (auto& r : readers) r.join();
+
+	test::assert_equal(pii(Adds / Size, 0), min.min(0, Size - 1));
+	test::assert_equal(int64(Adds), sum.sum(0, Size - 1));
+	test::assert_equal(int64(Adds / 2), sum.sum(0, Size / 2 - 1));
+}
+
+// The parallel build above SerialLen must give the same nodes as the serial one,
+// also for thread counts that are not a power of two.
+void TestSegmentTree20()
+{
+	struct Node
+	{
+		int64 sum;
+		int min;
+	};
+	using layout = segment_tree::heap_layout;
+	using iter = segment_tree::Iter<Node, layout>;
+
+	struct init_op
+	{
+		const vint& v;
+
+		void init(const iter& it)
+		{
+			it->sum = it->min = v[it.leaf_index()];
+		}
+		void recalc(const iter& it)
+		{
+			it->sum = it.left()->sum + it.right()->sum;
+			it->min = std::min(it.left()->min, it.right()->min);
+		}
+	};
+
+	mt19937 rnd(20);
+	for (int size : { (1 << 16) + 3, 1 << 17 })
+	{
+		vint v(size);
+		for (auto& x : v) x = int(rnd() % 2000) - 1000;
+		init_op op{ v };
+
+		segment_tree::Tree<Node, layout> exp;
+		exp.assign(size);
+		segment_tree::build(op, iter(exp));
+
+		for (int threads : { 2, 3, 8 })
+		{
+			segment_tree::Tree<Node, layout> act;
+			act.assign(size);
+			segment_tree::build_parallel(op, iter(act), threads);
+
+			forn(i, layout::nodes(size))
+			{
+				test::assert_equal(exp.node(i).sum, act.node(i).sum);
+				test::assert_equal(exp.node(i).min, act.node(i).min);
+			}
+		}
+	}
+}
+
+// Random chmin, chmax, add and sum with few distinct values, so that beats meets
+// nodes with equal maxima and minima and the second ones coincide often.
+void TestSegmentTree21()
+{
+	static const int INF = 1e9;
+	mt19937 rnd(21);
+	for (int size : { 1, 2, 7, 100, 257 })
+	{
+		AwesomeArrayTest<AwesomeArray<int>, ChminChmaxAddSumST<int, INF>> t;
+		vint v(size);
+		for (auto& x : v) x = int(rnd() % 21) - 10;
+		t.assign(v);
+
+		forn(i, 3000)
+		{
+			int l = rnd() % size, r = rnd() % size;
+			if (l > r) swap(l, r);
+			int val = int(rnd() % 21) - 10;
+			switch (rnd() % 4)
+			{
+			case 0: t.chmin(l, r, val); break;
+			case 1: t.chmax(l, r, val); break;
+			case 2: t.add(l, r, val / 2); break;
+			default: t.sum(l, r); break;
+			}
+		}
+		t.sum(0, size - 1);
+	}
+}
+
+// Linear assign and both paths of increment_batch against prefix sums of a plain array.
+void TestFenwik1()
+{
+	mt19937 rnd(14);
+	for (int size : { 1, 2, 5, 64, 1000 })
+	{
+		vint64 a(size);
+		for (auto& x : a) x = int(rnd() % 201) - 100;
+		Fenwik<int64> t;
+		t.assign(a);
+
+		auto check = [&]()
+		{
+			int64 prefix = 0;
+			forn(i, size)
+			{
+				prefix += a[i];
+				test::assert_equal(prefix, t.sum(i));
+			}
+		};
+		check();
+
+		// a few updates go one by one, a batch of size updates goes in one pass
+		for (int count : { 1, 3, size, 4 * size })
+		{
+			vector<pair<int, int64>> updates(count);
+			for (auto& u : updates)
+			{
+				u.first = rnd() % size;
+				u.second = int(rnd() % 201) - 100;
+				a[u.first] += u.second;
+			}
+			t.increment_batch(updates);
+			check();
+		}
+	}
+}
+
+// Sums over the 1-based cells and lower_bound against a linear scan, with many zero
+// weights and targets from 0 up to above the total.
+void TestFenwik2()
+{
+	mt19937 rnd(15);
+	for (int size : { 1, 2, 3, 8, 13, 100 })
+	{
+		vint64 a(size);
+		for (auto& x : a) x = rnd() % 3 == 0 ? int(rnd() % 5) : 0;
+		Fenwik<int64> t;
+		t.assign(size);
+		forn(i, size) t.increment(i, a[i]);
+
+		vint64 prefix(size);
+		partial_sum(all(a), prefix.begin());
+		test::assert_equal(int64(0), t.sum(-1));
+		forn(r, size)
+		{
+			test::assert_equal(prefix[r], t.sum(r));
+			forn(l, r + 1) test::assert_equal(prefix[r] - (l > 0 ? prefix[l-1] : 0), t.sum(l, r));
+		}
+
+		for (int64 k = 0; k <= prefix.back() + 2; ++k)
+		{
+			int exp = 0;
+			while (exp < size && prefix[exp] < k) ++exp;
+			test::assert_equal(exp, t.lower_bound(k));
+		}
+	}
+}
+
+// RangeFenwik against a plain array, both assigns included.
+void TestFenwik3()
+{
+	mt19937 rnd(16);
+	for (int size : { 1, 2, 7, 50 })
+	{
+		vint64 a(size);
+		for (auto& x : a) x = int(rnd() % 21) - 10;
+		RangeFenwik<int64> t;
+		t.assign(a);
+		// one of the sizes starts from the constant assign instead
+		if (size == 7)
+		{
+			a.assign(size, 3);
+			t.assign(size, 3);
+		}
+
+		forn(i, 500)
+		{
+			int l = rnd() % size, r = rnd() % size;
+			if (l > r) swap(l, r);
+			int64 val = int(rnd() % 21) - 10;
+			if (rnd() % 2)
+			{
+				for (int j = l; j <= r; ++j) a[j] += val;
+				t.increment(l, r, val);
+			}
+			else
+			{
+				test::assert_equal(accumulate(a.begin() + l, a.begin() + r + 1, int64(0)), t.sum(l, r));
+			}
+		}
+	}
+}
+
+// Fenwik2D and RangeFenwik2D against a plain matrix.
+void TestFenwik4()
+{
+	mt19937 rnd(16);
+	for (auto nm : { pii(1, 1), pii(1, 6), pii(5, 1), pii(7, 9), pii(16, 12) })
+	{
+		int n = nm.first, m = nm.second;
+		vector<vint64> a(n, vint64(m));
+		for (auto& row : a) for (auto& x : row) x = int(rnd() % 21) - 10;
+		Fenwik2D<int64> point;
+		point.assign(a);
+		RangeFenwik2D<int64> range;
+		range.assign(n, m);
+		forn(i, n) forn(j, m) range.increment(i, j, a[i][j]);
+
+		forn(k, 500)
+		{
+			int x1 = rnd() % n, x2 = rnd() % n, y1 = rnd() % m, y2 = rnd() % m;
+			if (x1 > x2) swap(x1, x2);
+			if (y1 > y2) swap(y1, y2);
+			int64 val = int(rnd() % 21) - 10;
+			switch (rnd() % 3)
+			{
+			case 0:
+				a[x1][y1] += val;
+				point.increment(x1, y1, val);
+				range.increment(x1, y1, val);
+				break;
+			case 1:
+				for (int i = x1; i <= x2; ++i) for (int j = y1; j <= y2; ++j)
+				{
+					a[i][j] += val;
+					point.increment(i, j, val);
+				}
+				range.increment(x1, y1, x2, y2, val);
+				break;
+			default:
+				int64 exp = 0;
+				for (int i = x1; i <= x2; ++i) for (int j = y1; j <= y2; ++j) exp += a[i][j];
+				test::assert_equal(exp, point.sum(x1, y1, x2, y2));
+				test::assert_equal(exp, range.sum(x1, y1, x2, y2));
+				break;
+			}
+		}
+	}
+}
+
+// BlockedFenwik against Fenwik, with partial last blocks and with more than one block level.
+template<typename T>
+void TestBlockedFenwikOf(mt19937& rnd)
+{
+	for (int size : { 1, 7, 17, 1000, (1 << 16) + 5, (1 << 21) + 3 })
+	{
+		vector<T> a(size);
+		for (auto& x : a) x = T(rnd() % 21) - 10;
+		Fenwik<T> exp;
+		exp.assign(a);
+		BlockedFenwik<T> act;
+		act.assign(a);
+
+		forn(i, 2000)
+		{
+			int l = rnd() % size, r = rnd() % size;
+			if (l > r) swap(l, r);
+			if (rnd() % 2)
+			{
+				T val = T(rnd() % 21) - 10;
+				exp.increment(l, val);
+				act.increment(l, val);
+			}
+			else
+			{
+				test::assert_equal(exp.sum(r), act.sum(r));
+				test::assert_equal(exp.sum(l, r), act.sum(l, r));
+			}
+		}
+		test::assert_equal(exp.sum(size - 1), act.sum(size - 1));
+	}
+}
+
+void TestFenwik5()
+{
+	mt19937 rnd(17);
+	TestBlockedFenwikOf<int>(rnd);
+	TestBlockedFenwikOf<int64>(rnd);
+}
+
+// Writers increment random cells while a reader watches the total only grow,
+// then every prefix sum must match the increments of all writers.
+void TestFenwik6()
+{
+	using fenwik_type = ConcurrentFenwik<int64>;
+	static const int Size = 1000;
+	static const int Writers = 4;
+	static const int Increments = 50000;
+
+	for (auto m : { fenwik_type::mode::atomic, fenwik_type::mode::sharded })
+	{
+		fenwik_type t;
+		t.assign(Size, m, 3);
+
+		vector<vint64> added(Writers, vint64(Size));
+		vector<std::thread> writers;
+		forn(k, Writers)
+		{
+			writers.emplace_back([&t, &added, k]()
+			{
+				mt19937 rnd(k);
+				forn(i, Increments)
+				{
+					int p = rnd() % Size;
+					int64 val = 1 + rnd() % 10;
+					added[k][p] += val;
+					t.increment(p, val);
+				}
+			});
+		}
+
+		atomic<bool> done(false);
+		std::thread reader([&]()
+		{
+			int64 last = 0;
+			while (!done.load())
+			{
+				int64 total = t.sum(Size - 1);
+				if (total < last) test::fail("total went down ", total);
+				last = total;
+			}
+		});
+
+		for (auto& w : writers) w.join();
+		done = true;
+		reader.join();
+
+		int64 prefix = 0;
+		forn(i, Size)
+		{
+			forn(k, Writers) prefix += added[k][i];
+			test::assert_equal(prefix, t.sum(i));
+		}
+	}
+}
+
 auto testsPub = tests::publish(
 	TestSegmentTree1,
-	TestSegmentTree2
+	TestSegmentTree2,
+	TestSegmentTree3,
+	TestSegmentTree4,
+	TestSegmentTree5,
+	TestSegmentTree6,
+	TestSegmentTree7,
+	TestSegmentTree8,
+	TestSegmentTree9,
+	TestSegmentTree10,
+	TestSegmentTree11,
+	TestSegmentTree12,
+	TestSegmentTree13,
+	TestSegmentTree14,
+	TestSegmentTree15,
+	TestSegmentTree16,
+	TestSegmentTree17,
+	TestSegmentTree18,
+	TestSegmentTree19,
+	TestSegmentTree20,
+	TestSegmentTree21,
+	TestFenwik1,
+	TestFenwik2,
+	TestFenwik3,
+	TestFenwik4,
+	TestFenwik5,
+	TestFenwik6
 );
\ No newline at end of file
@@ -33,11 +33,38 @@ namespace segment_tree
 		bool includes(const Pos& p) const { return l <= p.l && r >= p.r; }
 	};
 
-	template<typename TNode>
+	// Heap order: root 1, children 2i and 2i + 1, up to 4n nodes.
+	struct heap_layout
+	{
+		static int root() { return 1; }
+		static int nodes(int size)
+		{
+			int tsize = 1;
+			while (tsize < size) tsize <<= 1;
+			return tsize << 1;
+		}
+
+		static Pos left(const Pos& p) { return p.pleft(); }
+		static Pos right(const Pos& p) { return p.pright(); }
+	};
+
+	// DFS order: left child follows its node, right child follows the left subtree.
+	// Exactly 2n - 1 nodes.
+	struct dfs_layout
+	{
+		static int root() { return 0; }
+		static int nodes(int size) { return std::max(2 * size - 1, 1); }
+
+		static Pos left(const Pos& p) { return Pos(p.i + 1, p.l, p.m()); }
+		static Pos right(const Pos& p) { return Pos(p.i + 2 * (p.m() - p.l + 1), p.m() + 1, p.r); }
+	};
+
+	template<typename TNode, typename TLayout = heap_layout>
 	class Tree
 	{
 	public:
 		using node_type = TNode;
+		using layout_type = TLayout;
 
 	private:
 		vector<node_type> _t;
@@ -45,40 +72,65 @@ namespace segment_tree
 
 	public:
 		int size() const { return _size; }
+		// heap_layout only
+		int leaves() const { return int(_t.size()) >> 1; }
 		node_type& node(int i) { return _t[i]; }
+		const node_type& node(int i) const { return _t[i]; }
 
 		void assign(int size)
 		{
 			_size = size;
-			int tsize = 1;
-			while (tsize < size) tsize <<= 1;
-			tsize <<= 1;
-			_t.assign(tsize, node_type());
+			_t.assign(layout_type::nodes(size), node_type());
 		}
 	};
 
 
-	template<typename TNode>
+	template<typename TNode, typename TLayout = heap_layout>
 	struct Iter : public Pos
 	{
 		using node_type = TNode;
-		using tree_type = Tree<node_type>;
+		using layout_type = TLayout;
+		using tree_type = Tree<node_type, layout_type>;
 
 		tree_type& tree;
 
-		Iter(tree_type& tree) : Pos(1, 0, tree.size() - 1), tree(tree) {}
+		Iter(tree_type& tree) : Pos(layout_type::root(), 0, tree.size() - 1), tree(tree) {}
 		Iter(tree_type& tree, const Pos& p) : Pos(p), tree(tree) {}
 
-		Iter left() const { return Iter(tree, pleft()); }
-		Iter right() const { return Iter(tree, pright()); }
+		Iter left() const { return Iter(tree, layout_type::left(*this)); }
+		Iter right() const { return Iter(tree, layout_type::right(*this)); }
 
 		node_type& operator*() const { return tree.node(i); }
 		node_type* operator->() const { return &tree.node(i); }
 	};
 
+	// Iter over a const tree, for write-free traversals.
+	template<typename TNode, typename TLayout = heap_layout>
+	struct ConstIter : public Pos
+	{
+		using node_type = TNode;
+		using layout_type = TLayout;
+		using tree_type = Tree<node_type, layout_type>;
+
+		const tree_type& tree;
+
+		ConstIter(const tree_type& tree) : Pos(layout_type::root(), 0, tree.size() - 1), tree(tree) {}
+		ConstIter(const tree_type& tree, const Pos& p) : Pos(p), tree(tree) {}
+
+		ConstIter left() const { return ConstIter(tree, layout_type::left(*this)); }
+		ConstIter right() const { return ConstIter(tree, layout_type::right(*this)); }
+
+		const node_type& operator*() const { return tree.node(i); }
+		const node_type* operator->() const { return &tree.node(i); }
+	};
+
+	// The recursive engine accepts any iterator with the interface of Iter:
+	// Pos of the node, left(), right() and access to the node.
+	// modify and calc_const also accept any query with has_common(it) and includes(it).
+
 	// op.modify(it)
-	template<typename TOperation, typename TNode>
-	void modify_children(TOperation& op, const Iter<TNode>& it)
+	template<typename TOperation, typename TIter>
+	void modify_children(TOperation& op, const TIter& it)
 	{
 		if (it.is_leaf()) return;
 
@@ -87,8 +139,8 @@ namespace segment_tree
 	}
 
 	// op.init(it), op.recalc(it)
-	template<typename TOperation, typename TNode>
-	void build(TOperation& op, const Iter<TNode>& it)
+	template<typename TOperation, typename TIter>
+	void build(TOperation& op, const TIter& it)
 	{
 		if (it.is_leaf())
 		{
@@ -101,9 +153,90 @@ namespace segment_tree
 		op.recalc(it);
 	}
 
+	// op.init(it), op.recalc(it)
+	// Subtrees are built on up to threads threads, so op.init and op.recalc
+	// must allow calls for disjoint subtrees at the same time.
+	template<typename TOperation, typename TIter>
+	void build_parallel(TOperation& op, const TIter& it, int threads)
+	{
+		static const int SerialLen = 1 << 14;
+		if (threads <= 1 || it.len() <= SerialLen)
+		{
+			build(op, it);
+			return;
+		}
+
+		auto left = std::async(std::launch::async, [&op, &it, threads]()
+		{
+			build_parallel(op, it.left(), threads / 2);
+		});
+		build_parallel(op, it.right(), threads - threads / 2);
+		left.get();
+		op.recalc(it);
+	}
+
+	template<typename TOperation, typename TIter>
+	void build_parallel(TOperation& op, const TIter& it)
+	{
+		build_parallel(op, it, std::max<int>(1, std::thread::hardware_concurrency()));
+	}
+
+	// op.push(it), op.init(it), op.recalc(it)
+	// Builds only the leaves of the query and their ancestors,
+	// delayed modifications are pushed out of the rebuilt nodes first.
+	template<typename TOperation, typename TIter>
+	void build(TOperation& op, const TIter& it, const Query& q)
+	{
+		op.push(it);
+		if (!q.has_common(it)) return;
+
+		if (it.is_leaf())
+		{
+			op.init(it);
+			return;
+		}
+
+		build(op, it.left(), q);
+		build(op, it.right(), q);
+		op.recalc(it);
+	}
+
+	// op.push(it), op.get(it), op.merge(r1, r2)
+	// acc is the result of [l, it.l) on entry, the skipped nodes are merged into it.
+	template<typename TOperation, typename TIter, typename TPredicate>
+	int find_first(TOperation& op, const TIter& it, int l, TPredicate& pred, typename TOperation::result_type& acc)
+	{
+		if (it.r < l) return -1;
+
+		op.push(it);
+		if (it.l >= l)
+		{
+			auto next = op.merge(acc, op.get(it));
+			if (!pred(next))
+			{
+				acc = next;
+				return -1;
+			}
+			if (it.is_leaf()) return it.l;
+		}
+
+		int res = find_first(op, it.left(), l, pred, acc);
+		return res != -1 ? res : find_first(op, it.right(), l, pred, acc);
+	}
+
+	// op.push(it), op.zero(), op.get(it), op.merge(r1, r2)
+	// First i >= l for which pred(result of [l, i]) holds, -1 if none.
+	// pred must stay true once it holds, then it is one walk down in O(log n).
+	template<typename TOperation, typename TIter, typename TPredicate>
+	int find_first(TOperation& op, const TIter& it, int l, TPredicate pred)
+	{
+		auto acc = op.zero();
+		return find_first(op, it, l, pred, acc);
+	}
+
 	// op.push(it), op.zero(), op.get(it), op.merge(r1, r2) 
-	template<typename TOperation, typename TNode>
-	typename TOperation::result_type calc(TOperation& op, const Iter<TNode>& it, const Query& q)
+	template<typename TOperation, typename TIter>
+	typename TOperation::result_type calc(TOperation& op, const TIter& it, const Query& q)
 	{
 		if (!q.has_common(it)) return op.zero();
 
@@ -119,9 +252,28 @@ namespace segment_tree
 		);
 	}
 
+	// op.modify(it), op.recalc(it)
+	// For commutative delayed modifications that stay in the nodes: nothing is pushed,
+	// op.modify and op.recalc take the modification of it into account. Query with calc_const.
+	template<typename TOperation, typename TIter, typename TQuery>
+	void modify_no_push(TOperation& op, const TIter& it, const TQuery& q)
+	{
+		if (!q.has_common(it)) return;
+
+		if (q.includes(it))
+		{
+			op.modify(it);
+			return;
+		}
+
+		modify_no_push(op, it.left(), q);
+		modify_no_push(op, it.right(), q);
+		op.recalc(it);
+	}
+
 	// op.push(it), op.modify(it), op.recalc(it)
-	template<typename TOperation, typename TNode>
-	void modify(TOperation& op, const Iter<TNode>& it, const Query& q)
+	template<typename TOperation, typename TIter, typename TQuery>
+	void modify(TOperation& op, const TIter& it, const TQuery& q)
 	{
 		if (q.includes(it))
 		{
@@ -137,6 +289,215 @@ namespace segment_tree
 		modify(op, it.right(), q);
 		op.recalc(it);
 	}
+
+	// op.push(it), op.stop(it), op.tag(it), op.modify(it), op.recalc(it)
+	// Segment tree beats: subtrees with op.stop(it) are not affected, included nodes with op.tag(it)
+	// are modified as a whole, the others are split further. op.tag must hold for leaves.
+	// op.modify updates the node itself, op.push passes its delayed modification to the children.
+	template<typename TOperation, typename TIter, typename TQuery>
+	void modify_beats(TOperation& op, const TIter& it, const TQuery& q)
+	{
+		if (!q.has_common(it) || op.stop(it)) return;
+
+		if (q.includes(it) && op.tag(it))
+		{
+			op.modify(it);
+			return;
+		}
+
+		op.push(it);
+		modify_beats(op, it.left(), q);
+		modify_beats(op, it.right(), q);
+		op.recalc(it);
+	}
+
+	// op.zero(), op.get(it, tag), op.down(it, tag), op.merge(r1, r2)
+	// Write-free: delayed modifications stay in the nodes, tag carries the ones of the ancestors
+	// and op.down(it, tag) composes it with the one of it.
+	template<typename TOperation, typename TIter, typename TQuery, typename TTag>
+	typename TOperation::result_type calc_const(TOperation& op, const TIter& it, const TQuery& q, const TTag& tag)
+	{
+		if (!q.has_common(it)) return op.zero();
+
+		if (q.includes(it))
+		{
+			return op.get(it, tag);
+		}
+
+		TTag down = op.down(it, tag);
+		return op.merge(
+			calc_const(op, it.left(), q, down),
+			calc_const(op, it.right(), q, down)
+		);
+	}
+
+	// op.push(it), op.get(it), op.merge(r1, r2)
+	// ids[from, to) are the queries of the batch touching it but not including its parent.
+	template<typename TOperation, typename TIter>
+	void calc_batch(TOperation& op, const TIter& it, const vector<Query>& qs,
+		vint& ids, int from, int to, vector<typename TOperation::result_type>& res)
+	{
+		op.push(it);
+		
+		int end = ids.size();
+		for (int k = from; k < to; ++k)
+		{
+			int qi = ids[k];
+			if (qs[qi].includes(it)) res[qi] = op.merge(res[qi], op.get(it));
+			else ids.push_back(qi);
+		}
+
+		if (end == int(ids.size())) return;
+		int m = it.m();
+
+		// ids are sorted by l, so queries going to the left child are a prefix
+		int mid = end;
+		while (mid < int(ids.size()) && qs[ids[mid]].l <= m) ++mid;
+		if (mid > end) calc_batch(op, it.left(), qs, ids, end, mid, res);
+
+		int rfrom = ids.size();
+		for (int k = end; k < rfrom; ++k)
+		{
+			if (qs[ids[k]].r > m) ids.push_back(ids[k]);
+		}
+		if (int(ids.size()) > rfrom) calc_batch(op, it.right(), qs, ids, rfrom, ids.size(), res);
+		ids.resize(end);
+	}
+
+	// op.push(it), op.zero(), op.get(it), op.merge(r1, r2)
+	// Answers all queries in one traversal, every node is visited and pushed at most once.
+	template<typename TOperation, typename TIter>
+	void calc_batch(TOperation& op, const TIter& it, const vector<Query>& qs,
+		vector<typename TOperation::result_type>& res)
+	{
+		res.assign(qs.size(), op.zero());
+
+		vint ids;
+		ids.reserve(4 * qs.size());
+		forn(i, qs.size())
+		{
+			if (qs[i].l <= qs[i].r && qs[i].has_common(it)) ids.push_back(i);
+		}
+		sort(all(ids), [&qs](int a, int b) { return qs[a].l < qs[b].l; });
+
+		if (!ids.empty()) calc_batch(op, it, qs, ids, 0, ids.size(), res);
+	}
+
+	// Iterative engine for operations without delayed modifications.
+	// Leaf k is stored at tree.leaves() + k, so node i on the level with span s
+	// covers leaves [i*s, i*s + s). op.push is never called.
+	// Nodes covering padding leaves past tree.size() are never returned by calc.
+	namespace bottom_up
+	{
+		template<typename TNode>
+		Iter<TNode> at(Tree<TNode>& tree, int i, int span)
+		{
+			int l = i * span - tree.leaves();
+			return Iter<TNode>(tree, Pos(i, l, l + span - 1));
+		}
+
+		// op.init(it), op.recalc(it)
+		template<typename TOperation, typename TNode>
+		void build(TOperation& op, Tree<TNode>& tree)
+		{
+			int n = tree.leaves();
+			for (int k = 0; k < tree.size(); ++k)
+			{
+				op.init(at(tree, n + k, 1));
+			}
+
+			for (int b = n >> 1, span = 2; b >= 1; b >>= 1, span <<= 1)
+			{
+				for (int i = b; i < (b << 1) && i * span - n < tree.size(); ++i)
+				{
+					op.recalc(at(tree, i, span));
+				}
+			}
+		}
+
+		// op.zero(), op.get(it), op.merge(r1, r2)
+		template<typename TOperation, typename TNode>
+		typename TOperation::result_type calc(TOperation& op, Tree<TNode>& tree, const Query& q)
+		{
+			auto lres = op.zero();
+			auto rres = op.zero();
+			int l = q.l + tree.leaves(), r = q.r + tree.leaves() + 1;
+			for (int span = 1; l < r; l >>= 1, r >>= 1, span <<= 1)
+			{
+				if (l & 1) lres = op.merge(lres, op.get(at(tree, l++, span)));
+				if (r & 1) rres = op.merge(op.get(at(tree, --r, span)), rres);
+			}
+			return op.merge(lres, rres);
+		}
+
+		// op.modify(it), op.recalc(it)
+		// Every leaf of the query is modified, so use it for point updates.
+		template<typename TOperation, typename TNode>
+		void modify(TOperation& op, Tree<TNode>& tree, const Query& q)
+		{
+			int l = q.l + tree.leaves(), r = q.r + tree.leaves();
+			for (int i = l; i <= r; ++i)
+			{
+				op.modify(at(tree, i, 1));
+			}
+
+			for (int span = 2; l > 1; span <<= 1)
+			{
+				l >>= 1;
+				r >>= 1;
+				for (int i = l; i <= r; ++i)
+				{
+					op.recalc(at(tree, i, span));
+				}
+			}
+		}
+	}
+
+	// Operation is lazy if it has op.push.
+	template<typename TOperation, typename = void>
+	struct is_lazy : std::false_type {};
+
+	template<typename TOperation>
+	struct is_lazy<TOperation, decltype(void(&TOperation::push))> : std::true_type {};
+
+	// Engine selection for the whole tree: lazy operations go recursively
+	// from the root, the others go bottom-up.
+	// Operations used with one tree must agree, the engines have different layouts.
+	template<typename TOperation, typename TNode>
+	void build(TOperation& op, Tree<TNode>& tree, std::true_type) { build(op, Iter<TNode>(tree)); }
+	template<typename TOperation, typename TNode>
+	void build(TOperation& op, Tree<TNode>& tree, std::false_type) { bottom_up::build(op, tree); }
+	template<typename TOperation, typename TNode>
+	void build(TOperation& op, Tree<TNode>& tree)
+	{
+		build(op, tree, is_lazy<TOperation>());
+	}
+
+	template<typename TOperation, typename TNode>
+	typename TOperation::result_type calc(TOperation& op, Tree<TNode>& tree, const Query& q, std::true_type)
+	{
+		return calc(op, Iter<TNode>(tree), q);
+	}
+	template<typename TOperation, typename TNode>
+	typename TOperation::result_type calc(TOperation& op, Tree<TNode>& tree, const Query& q, std::false_type)
+	{
+		return bottom_up::calc(op, tree, q);
+	}
+	template<typename TOperation, typename TNode>
+	typename TOperation::result_type calc(TOperation& op, Tree<TNode>& tree, const Query& q)
+	{
+		return calc(op, tree, q, is_lazy<TOperation>());
+	}
+
+	template<typename TOperation, typename TNode>
+	void modify(TOperation& op, Tree<TNode>& tree, const Query& q, std::true_type) { modify(op, Iter<TNode>(tree), q); }
+	template<typename TOperation, typename TNode>
+	void modify(TOperation& op, Tree<TNode>& tree, const Query& q, std::false_type) { bottom_up::modify(op, tree, q); }
+	template<typename TOperation, typename TNode>
+	void modify(TOperation& op, Tree<TNode>& tree, const Query& q)
+	{
+		modify(op, tree, q, is_lazy<TOperation>());
+	}
 }
 
 template<typename T>
@@ -214,7 +575,7 @@ public:
 
 
 
-template<typename T>
+template<typename T, typename TLayout = segment_tree::heap_layout>
 class AddSumST
 {
 	struct Node
@@ -224,8 +585,8 @@ class AddSumST
 		Node() : sum(0), add(0) {}
 	};
 
-	using iter = segment_tree::Iter<Node>;
-	segment_tree::Tree<Node> _tree;
+	using iter = segment_tree::Iter<Node, TLayout>;
+	mutable segment_tree::Tree<Node, TLayout> _tree;
 	iter root() const { return _tree; }
 	
 	struct calc_op
@@ -235,7 +596,7 @@ class AddSumST
 			Node& node = *it;
 			if (node.add != 0)
 			{
-				segment_tree::apply_to_children(add_op(node.add), it);
+				segment_tree::modify_children(add_op(node.add), it);
 				node.sum += node.add * it.len();
 				node.add = 0;
 			}
@@ -296,6 +657,19 @@ public:
 		return segment_tree::calc(sum_op(), root(), segment_tree::Query(l, r));
 	}
 
+	// first i >= l with pred(sum(l, i)), -1 if none; pred must stay true once it holds
+	template<typename TPredicate>
+	int find_first(int l, TPredicate pred) const
+	{
+		return segment_tree::find_first(sum_op(), root(), l, pred);
+	}
+
+	// first i with sum(0, i) >= k for non-negative values, -1 if none
+	int find_prefix_at_least(T k) const
+	{
+		return find_first(0, [k](T sum) { return sum >= k; });
+	}
+
 	void add(int l, int r, T val)
 	{
 		return segment_tree::modify(add_op(val), root(), segment_tree::Query(l, r));
@@ -304,7 +678,7 @@ public:
 };
 
 
-template<typename T>
+template<typename T, typename TLayout = segment_tree::heap_layout>
 class AddSetSumST
 {
 	static const int UNDEF = -1e9;
@@ -316,8 +690,8 @@ class AddSetSumST
 		Node() : sum(0), add(0), set(UNDEF) {}
 	};
 
-	using iter = segment_tree::Iter<Node>;
-	mutable segment_tree::Tree<Node> _tree;
+	using iter = segment_tree::Iter<Node, TLayout>;
+	mutable segment_tree::Tree<Node, TLayout> _tree;
 	iter root() const { return _tree; }
 
 	struct calc_op
@@ -358,6 +732,19 @@ class AddSetSumST
 			it->sum = v[it.leaf_index()];
 		}
 	};
+
+	template<typename TIterator>
+	struct init_range_op : public mod_op
+	{
+		TIterator first;
+		int l;
+		init_range_op(TIterator first, int l) : first(first), l(l) {}
+
+		void init(const iter& it)
+		{
+			it->sum = first[it.leaf_index() - l];
+		}
+	};
 	
 	struct add_op : public mod_op
 	{
@@ -407,7 +794,13 @@ public:
 	void assign(const vector<T>& vals)
 	{
 		assign(vals.size());
-		segment_tree::build(init_vec_op(vals), root());
+		segment_tree::build_parallel(init_vec_op(vals), root());
+	}
+	// [l, r] = [first, first + r - l], first is random access
+	template<typename TIterator>
+	void assign_range(int l, int r, TIterator first)
+	{
+		segment_tree::build(init_range_op<TIterator>(first, l), root(), segment_tree::Query(l, r));
 	}
 
 	T sum(int l, int r) const
@@ -415,6 +808,25 @@ public:
 		return segment_tree::calc(sum_op(), root(), segment_tree::Query(l, r));
 	}
 
+	// first i >= l with pred(sum(l, i)), -1 if none; pred must stay true once it holds
+	template<typename TPredicate>
+	int find_first(int l, TPredicate pred) const
+	{
+		return segment_tree::find_first(sum_op(), root(), l, pred);
+	}
+
+	// first i with sum(0, i) >= k for non-negative values, -1 if none
+	int find_prefix_at_least(T k) const
+	{
+		return find_first(0, [k](T sum) { return sum >= k; });
+	}
+
+	// res[i] = sum(qs[i].l, qs[i].r)
+	void sum_batch(const vector<segment_tree::Query>& qs, vector<T>& res) const
+	{
+		segment_tree::calc_batch(sum_op(), root(), qs, res);
+	}
+
 	void add(int l, int r, T val)
 	{
 		return segment_tree::modify(add_op(val), root(), segment_tree::Query(l, r));
@@ -428,7 +840,7 @@ public:
 };
 
 
-template<typename T, T INF = T(1e9)>
+template<typename T, T INF = T(1e9), typename TLayout = segment_tree::heap_layout>
 class AddMinST
 {
 	struct Node
@@ -444,8 +856,8 @@ class AddMinST
 		}
 	};
 
-	using iter = segment_tree::Iter<Node>;
-	mutable segment_tree::Tree<Node> _tree;
+	using iter = segment_tree::Iter<Node, TLayout>;
+	mutable segment_tree::Tree<Node, TLayout> _tree;
 	iter root() const { return _tree; }	
 	
 	struct calc_op
@@ -492,6 +904,19 @@ class AddMinST
 		}
 	};
 
+	template<typename TIterator>
+	struct init_range_op : public mod_op
+	{
+		TIterator first;
+		int l;
+		init_range_op(TIterator first, int l) : first(first), l(l) {}
+
+		void init(const iter& it)
+		{
+			it->init(first[it.leaf_index() - l], it.leaf_index());
+		}
+	};
+
 	struct add_op : public mod_op
 	{
 		T val;
@@ -525,12 +950,18 @@ public:
 	void assign(int size, const T& val = 0)
 	{
 		_tree.assign(size);
-		segment_tree::build(init_const_op(val), root());
+		segment_tree::build_parallel(init_const_op(val), root());
 	}
 	void assign(const vector<T>& vals)
 	{
 		_tree.assign(vals.size());
-		segment_tree::build(init_vec_op(vals), root());
+		segment_tree::build_parallel(init_vec_op(vals), root());
+	}
+	// [l, r] = [first, first + r - l], first is random access
+	template<typename TIterator>
+	void assign_range(int l, int r, TIterator first)
+	{
+		segment_tree::build(init_range_op<TIterator>(first, l), root(), segment_tree::Query(l, r));
 	}
 
 	pair<T, int> min(int l, int r) const
@@ -538,9 +969,659 @@ public:
 		return segment_tree::calc(min_op(), root(), segment_tree::Query(l, r));
 	}
 
+	// first i >= l with pred(min(l, i)), -1 if none; pred must stay true once it holds
+	template<typename TPredicate>
+	int find_first(int l, TPredicate pred) const
+	{
+		return segment_tree::find_first(min_op(), root(), l, pred);
+	}
+
+	// first i >= l with value <= x, -1 if none
+	int find_first_at_most(int l, T x) const
+	{
+		return find_first(l, [x](const pair<T, int>& m) { return m.first <= x; });
+	}
+
+	// res[i] = min(qs[i].l, qs[i].r)
+	void min_batch(const vector<segment_tree::Query>& qs, vector<pair<T, int>>& res) const
+	{
+		segment_tree::calc_batch(min_op(), root(), qs, res);
+	}
+
 	void add(int l, int r, T val)
 	{
 		return segment_tree::modify(add_op(val), root(), segment_tree::Query(l, r));
 	}
 
+};
+
+
+// Range add keeps the adds in the nodes, so sum only reads the tree.
+template<typename T, typename TLayout = segment_tree::heap_layout>
+class NoPushAddSumST
+{
+	// sum includes add
+	struct Node
+	{
+		T sum;
+		T add;
+		Node() : sum(0), add(0) {}
+	};
+
+	using iter = segment_tree::Iter<Node, TLayout>;
+	using citer = segment_tree::ConstIter<Node, TLayout>;
+	segment_tree::Tree<Node, TLayout> _tree;
+	iter root() { return _tree; }
+	citer root() const { return _tree; }
+
+	struct mod_op
+	{
+		void recalc(const iter& it)
+		{
+			it->sum = it.left()->sum + it.right()->sum + it->add * it.len();
+		}
+	};
+
+	struct init_vec_op : public mod_op
+	{
+		const vector<T>& v;
+		init_vec_op(const vector<T>& v) : v(v) {}
+
+		void init(const iter& it)
+		{
+			it->sum = v[it.leaf_index()];
+		}
+	};
+
+	struct add_op : public mod_op
+	{
+		T val;
+		add_op(const T& val) : val(val) {}
+
+		void modify(const iter& it)
+		{
+			it->add += val;
+			it->sum += val * it.len();
+		}
+	};
+
+	// tag is the sum of adds of the ancestors
+	struct sum_op
+	{
+		using result_type = T;
+		T zero() { return 0; }
+		T get(const citer& it, T add) { return it->sum + add * it.len(); }
+		T down(const citer& it, T add) { return it->add + add; }
+		T merge(T left, T right) { return left + right; }
+	};
+
+public:
+	void assign(int size)
+	{
+		_tree.assign(size);
+	}
+	void assign(const vector<T>& vals)
+	{
+		assign(vals.size());
+		segment_tree::build(init_vec_op(vals), root());
+	}
+
+	T sum(int l, int r) const
+	{
+		return segment_tree::calc_const(sum_op(), root(), segment_tree::Query(l, r), T(0));
+	}
+
+	void add(int l, int r, T val)
+	{
+		segment_tree::modify_no_push(add_op(val), root(), segment_tree::Query(l, r));
+	}
+
+};
+
+
+// Range add keeps the adds in the nodes, so min only reads the tree.
+template<typename T, T INF = T(1e9), typename TLayout = segment_tree::heap_layout>
+class NoPushAddMinST
+{
+	// minp includes add
+	struct Node
+	{
+		pair<T, int> minp;
+		T add;
+
+		void init(T val, int index)
+		{
+			minp.first = val;
+			minp.second = index;
+			add = 0;
+		}
+	};
+
+	using iter = segment_tree::Iter<Node, TLayout>;
+	using citer = segment_tree::ConstIter<Node, TLayout>;
+	segment_tree::Tree<Node, TLayout> _tree;
+	iter root() { return _tree; }
+	citer root() const { return _tree; }
+
+	struct mod_op
+	{
+		void recalc(const iter& it)
+		{
+			it->minp = std::min(it.left()->minp, it.right()->minp);
+			it->minp.first += it->add;
+		}
+	};
+
+	struct init_vec_op : public mod_op
+	{
+		const vector<T>& v;
+		init_vec_op(const vector<T>& v) : v(v) {}
+
+		void init(const iter& it)
+		{
+			it->init(v[it.leaf_index()], it.leaf_index());
+		}
+	};
+
+	struct init_const_op : public mod_op
+	{
+		T val;
+		init_const_op(const T& val) : val(val) {}
+
+		void init(const iter& it)
+		{
+			it->init(val, it.leaf_index());
+		}
+	};
+
+	struct add_op : public mod_op
+	{
+		T val;
+		add_op(const T& val) : val(val) {}
+
+		void modify(const iter& it)
+		{
+			it->add += val;
+			it->minp.first += val;
+		}
+	};
+
+	// tag is the sum of adds of the ancestors
+	struct min_op
+	{
+		using result_type = pair<T, int>;
+
+		result_type zero()
+		{
+			return result_type(INF, -1);
+		}
+		result_type get(const citer& it, T add)
+		{
+			return result_type(it->minp.first + add, it->minp.second);
+		}
+		T down(const citer& it, T add)
+		{
+			return it->add + add;
+		}
+		result_type merge(result_type left, result_type right)
+		{
+			return std::min(left, right);
+		}
+	};
+
+public:
+	void assign(int size, const T& val = 0)
+	{
+		_tree.assign(size);
+		segment_tree::build(init_const_op(val), root());
+	}
+	void assign(const vector<T>& vals)
+	{
+		_tree.assign(vals.size());
+		segment_tree::build(init_vec_op(vals), root());
+	}
+
+	pair<T, int> min(int l, int r) const
+	{
+		return segment_tree::calc_const(min_op(), root(), segment_tree::Query(l, r), T(0));
+	}
+
+	void add(int l, int r, T val)
+	{
+		segment_tree::modify_no_push(add_op(val), root(), segment_tree::Query(l, r));
+	}
+
+};
+
+
+// Segment tree beats: range chmin, chmax and add in amortized O(log^2 n), range sum.
+template<typename T, T INF = T(1e9), typename TLayout = segment_tree::heap_layout>
+class ChminChmaxAddSumST
+{
+	// Values of the node include its own modifications, add is delayed for the children.
+	// max2 and min2 are strict, -INF and INF if all values are equal.
+	struct Node
+	{
+		T sum;
+		T max1, max2;
+		T min1, min2;
+		int maxc, minc;
+		T add;
+
+		void init(T val)
+		{
+			sum = max1 = min1 = val;
+			max2 = -INF;
+			min2 = INF;
+			maxc = minc = 1;
+			add = 0;
+		}
+
+		void apply_add(T val, int len)
+		{
+			sum += val * len;
+			max1 += val;
+			if (max2 != -INF) max2 += val;
+			min1 += val;
+			if (min2 != INF) min2 += val;
+			add += val;
+		}
+
+		// max2 < x
+		void apply_chmin(T x)
+		{
+			if (max1 <= x) return;
+
+			sum -= (max1 - x) * maxc;
+			if (min1 == max1) min1 = x;
+			else if (min2 == max1) min2 = x;
+			max1 = x;
+		}
+
+		// min2 > x
+		void apply_chmax(T x)
+		{
+			if (min1 >= x) return;
+
+			sum += (x - min1) * minc;
+			if (max1 == min1) max1 = x;
+			else if (max2 == min1) max2 = x;
+			min1 = x;
+		}
+	};
+
+	using iter = segment_tree::Iter<Node, TLayout>;
+	mutable segment_tree::Tree<Node, TLayout> _tree;
+	iter root() const { return _tree; }
+
+	struct calc_op
+	{
+		// max1 and min1 of it bound the values of the children
+		void push(const iter& it)
+		{
+			Node& node = *it;
+			if (it.is_leaf()) return;
+
+			if (node.add != 0)
+			{
+				segment_tree::modify_children(add_op(node.add), it);
+				node.add = 0;
+			}
+			segment_tree::modify_children(chmin_op(node.max1), it);
+			segment_tree::modify_children(chmax_op(node.min1), it);
+		}
+	};
+
+	struct mod_op : public calc_op
+	{
+		void recalc(const iter& it)
+		{
+			const Node& a = *it.left();
+			const Node& b = *it.right();
+			Node& node = *it;
+
+			node.sum = a.sum + b.sum;
+
+			if (a.max1 == b.max1)
+			{
+				node.max1 = a.max1;
+				node.maxc = a.maxc + b.maxc;
+				node.max2 = std::max(a.max2, b.max2);
+			}
+			else
+			{
+				const Node& hi = (a.max1 > b.max1 ? a : b);
+				const Node& lo = (a.max1 > b.max1 ? b : a);
+				node.max1 = hi.max1;
+				node.maxc = hi.maxc;
+				node.max2 = std::max(hi.max2, lo.max1);
+			}
+
+			if (a.min1 == b.min1)
+			{
+				node.min1 = a.min1;
+				node.minc = a.minc + b.minc;
+				node.min2 = std::min(a.min2, b.min2);
+			}
+			else
+			{
+				const Node& lo = (a.min1 < b.min1 ? a : b);
+				const Node& hi = (a.min1 < b.min1 ? b : a);
+				node.min1 = lo.min1;
+				node.minc = lo.minc;
+				node.min2 = std::min(lo.min2, hi.min1);
+			}
+		}
+	};
+
+	struct init_vec_op : public mod_op
+	{
+		const vector<T>& v;
+		init_vec_op(const vector<T>& v) : v(v) {}
+
+		void init(const iter& it)
+		{
+			it->init(v[it.leaf_index()]);
+		}
+	};
+
+	struct init_const_op : public mod_op
+	{
+		T val;
+		init_const_op(const T& val) : val(val) {}
+
+		void init(const iter& it)
+		{
+			it->init(val);
+		}
+	};
+
+	struct add_op : public mod_op
+	{
+		T val;
+		add_op(const T& val) : val(val) {}
+
+		bool stop(const iter&) { return false; }
+		bool tag(const iter&) { return true; }
+		void modify(const iter& it)
+		{
+			it->apply_add(val, it.len());
+		}
+	};
+
+	struct chmin_op : public mod_op
+	{
+		T val;
+		chmin_op(const T& val) : val(val) {}
+
+		bool stop(const iter& it) { return it->max1 <= val; }
+		bool tag(const iter& it) { return it->max2 < val; }
+		void modify(const iter& it)
+		{
+			it->apply_chmin(val);
+		}
+	};
+
+	struct chmax_op : public mod_op
+	{
+		T val;
+		chmax_op(const T& val) : val(val) {}
+
+		bool stop(const iter& it) { return it->min1 >= val; }
+		bool tag(const iter& it) { return it->min2 > val; }
+		void modify(const iter& it)
+		{
+			it->apply_chmax(val);
+		}
+	};
+
+	struct sum_op : public calc_op
+	{
+		using result_type = T;
+		T zero() { return 0; }
+		T get(const iter& it) { return it->sum; }
+		T merge(T left, T right) { return left + right; }
+	};
+
+public:
+	void assign(int size, const T& val = 0)
+	{
+		_tree.assign(size);
+		segment_tree::build(init_const_op(val), root());
+	}
+	void assign(const vector<T>& vals)
+	{
+		_tree.assign(vals.size());
+		segment_tree::build(init_vec_op(vals), root());
+	}
+
+	T sum(int l, int r) const
+	{
+		return segment_tree::calc(sum_op(), root(), segment_tree::Query(l, r));
+	}
+
+	void add(int l, int r, T val)
+	{
+		segment_tree::modify_beats(add_op(val), root(), segment_tree::Query(l, r));
+	}
+
+	// a[i] = min(a[i], val)
+	void chmin(int l, int r, T val)
+	{
+		segment_tree::modify_beats(chmin_op(val), root(), segment_tree::Query(l, r));
+	}
+
+	// a[i] = max(a[i], val)
+	void chmax(int l, int r, T val)
+	{
+		segment_tree::modify_beats(chmax_op(val), root(), segment_tree::Query(l, r));
+	}
+
+};
+
+
+template<typename T>
+class SumST
+{
+	struct Node
+	{
+		T sum;
+		Node() : sum(0) {}
+	};
+
+	using iter = segment_tree::Iter<Node>;
+	mutable segment_tree::Tree<Node> _tree;
+
+	struct mod_op
+	{
+		void recalc(const iter& it)
+		{
+			it->sum = it.left()->sum + it.right()->sum;
+		}
+	};
+
+	struct init_vec_op : public mod_op
+	{
+		const vector<T>& v;
+		init_vec_op(const vector<T>& v) : v(v) {}
+
+		void init(const iter& it)
+		{
+			it->sum = v[it.leaf_index()];
+		}
+	};
+
+	struct add_op : public mod_op
+	{
+		T val;
+		add_op(const T& val) : val(val) {}
+
+		void modify(const iter& it)
+		{
+			it->sum += val;
+		}
+	};
+
+	struct set_op : public mod_op
+	{
+		T val;
+		set_op(const T& val) : val(val) {}
+
+		void modify(const iter& it)
+		{
+			it->sum = val;
+		}
+	};
+
+	struct sum_op
+	{
+		using result_type = T;
+		T zero() { return 0; }
+		T get(const iter& it) { return it->sum; }
+		T merge(T left, T right) { return left + right; }
+	};
+
+public:
+	void assign(int size)
+	{
+		_tree.assign(size);
+	}
+	void assign(const vector<T>& vals)
+	{
+		assign(vals.size());
+		segment_tree::build(init_vec_op(vals), _tree);
+	}
+
+	T sum(int l, int r) const
+	{
+		return segment_tree::calc(sum_op(), _tree, segment_tree::Query(l, r));
+	}
+
+	void add(int i, T val)
+	{
+		return segment_tree::modify(add_op(val), _tree, segment_tree::Query(i, i));
+	}
+
+	void set(int i, T val)
+	{
+		return segment_tree::modify(set_op(val), _tree, segment_tree::Query(i, i));
+	}
+
+};
+
+
+template<typename T, T INF = T(1e9)>
+class MinST
+{
+	struct Node
+	{
+		pair<T, int> minp;
+
+		void init(T val, int index)
+		{
+			minp.first = val;
+			minp.second = index;
+		}
+	};
+
+	using iter = segment_tree::Iter<Node>;
+	mutable segment_tree::Tree<Node> _tree;
+
+	struct mod_op
+	{
+		void recalc(const iter& it)
+		{
+			it->minp = std::min(it.left()->minp, it.right()->minp);
+		}
+	};
+
+	struct init_vec_op : public mod_op
+	{
+		const vector<T>& v;
+		init_vec_op(const vector<T>& v) : v(v) {}
+
+		void init(const iter& it)
+		{
+			it->init(v[it.leaf_index()], it.leaf_index());
+		}
+	};
+
+	struct init_const_op : public mod_op
+	{
+		T val;
+		init_const_op(const T& val) : val(val) {}
+
+		void init(const iter& it)
+		{
+			it->init(val, it.leaf_index());
+		}
+	};
+
+	struct add_op : public mod_op
+	{
+		T val;
+		add_op(const T& val) : val(val) {}
+
+		void modify(const iter& it)
+		{
+			it->minp.first += val;
+		}
+	};
+
+	struct set_op : public mod_op
+	{
+		T val;
+		set_op(const T& val) : val(val) {}
+
+		void modify(const iter& it)
+		{
+			it->minp.first = val;
+		}
+	};
+
+	struct min_op
+	{
+		using result_type = pair<T, int>;
+
+		result_type zero()
+		{
+			return result_type(INF, -1);
+		}
+		result_type get(const iter& it)
+		{
+			return it->minp;
+		}
+		result_type merge(result_type left, result_type right)
+		{
+			return std::min(left, right);
+		}
+	};
+
+public:
+	void assign(int size, const T& val = 0)
+	{
+		_tree.assign(size);
+		segment_tree::build(init_const_op(val), _tree);
+	}
+	void assign(const vector<T>& vals)
+	{
+		_tree.assign(vals.size());
+		segment_tree::build(init_vec_op(vals), _tree);
+	}
+
+	pair<T, int> min(int l, int r) const
+	{
+		return segment_tree::calc(min_op(), _tree, segment_tree::Query(l, r));
+	}
+
+	void add(int i, T val)
+	{
+		return segment_tree::modify(add_op(val), _tree, segment_tree::Query(i, i));
+	}
+
+	void set(int i, T val)
+	{
+		return segment_tree::modify(set_op(val), _tree, segment_tree::Query(i, i));
+	}
+
 };
\ No newline at end of file
@@ -0,0 +1,352 @@
+#include "SegmentTree.h"
+#include "WideSegmentTree.h"
+#include "Fenwick.h"
+#include "BlockedFenwick.h"
+#include "ConcurrentFenwick.h"
+#include "ConcurrentSegmentTree.h"
+#include "Treap.h"
+#include "AwesomeArray.h"
+#include "_bench.h"
+
+
+static const int BenchQueries = 1000000;
+
+template<typename TTree, typename TQuery>
+void BenchQueriesOn(const string& name, const vint& v, const vector<pii>& qs, TQuery query)
+{
+	TTree t;
+	t.assign(v);
+
+	int64 acc = 0;
+	double seconds = bench::measure([&]()
+	{
+		for (const auto& q : qs) acc += query(t, q.first, q.second);
+	});
+	bench::consume(acc);
+	bench::report(name, v.size(), qs.size(), seconds);
+}
+
+void BenchWideSegmentTree()
+{
+	mt19937 rnd(42);
+	for (int size : { 100000, 1000000, 10000000, 100000000 })
+	{
+		vint v(size);
+		for (auto& x : v) x = rnd() % 10;
+
+		vector<pii> qs(BenchQueries);
+		for (auto& q : qs)
+		{
+			q.first = rnd() % size;
+			q.second = rnd() % size;
+			if (q.first > q.second) swap(q.first, q.second);
+		}
+
+		auto min_query = [](const auto& t, int l, int r) { return t.min(l, r).second; };
+		auto sum_query = [](const auto& t, int l, int r) { return t.sum(l, r); };
+
+		BenchQueriesOn<AddMinST<int>>("AddMinST.min", v, qs, min_query);
+		BenchQueriesOn<MinST<int>>("MinST.min", v, qs, min_query);
+		BenchQueriesOn<WideMinST<int>>("WideMinST.min", v, qs, min_query);
+		BenchQueriesOn<AddSetSumST<int>>("AddSetSumST.sum", v, qs, sum_query);
+		BenchQueriesOn<SumST<int>>("SumST.sum", v, qs, sum_query);
+		BenchQueriesOn<WideSumST<int>>("WideSumST.sum", v, qs, sum_query);
+	}
+}
+
+static const int BenchOps = 200000;
+// the naive baseline is O(n) per operation
+static const int NaiveMaxSize = 1 << 12;
+
+void BenchRangeQueries()
+{
+	using bench::operation;
+	auto range_add = [](auto& t, const operation& op) { t.add(op.l, op.r, op.val); };
+	auto sum_query = [](auto& t, const operation& op) { return t.sum(op.l, op.r); };
+	auto min_query = [](auto& t, const operation& op) { return t.min(op.l, op.r).second; };
+	auto increment = [](auto& t, const operation& op) { t.increment(op.l, op.val); };
+	auto range_increment = [](auto& t, const operation& op) { t.increment(op.l, op.r, op.val); };
+	auto point_add = [](auto& t, const operation& op) { t.add(op.l, op.val); };
+
+	for (int size : { 1 << 12, 1 << 16, 1 << 20 })
+	{
+		// name, size, ops, update percent, max range length, skew, point updates
+		vector<bench::workload> workloads{
+			{ "read_heavy", size, BenchOps, 10, size, 0, false },
+			{ "balanced", size, BenchOps, 50, size, 0, false },
+			{ "write_heavy", size, BenchOps, 90, size, 0, false },
+			{ "short_ranges", size, BenchOps, 50, 16, 0, false },
+			{ "skewed", size, BenchOps, 50, size, 3, false },
+			{ "point_updates", size, BenchOps, 50, size, 0, true },
+		};
+
+		for (const auto& w : workloads)
+		{
+			auto ops = bench::generate(w);
+
+			bench::run_workload<AddSumST<int64>>("AddSumST", w, ops, range_add, sum_query);
+			bench::run_workload<RangeFenwik<int64>>("RangeFenwik", w, ops, range_increment, sum_query);
+			bench::run_workload<AddSetSumST<int64>>("AddSetSumST", w, ops, range_add, sum_query);
+			bench::run_workload<AddMinST<int64>>("AddMinST", w, ops, range_add, min_query);
+			if (w.point_updates)
+			{
+				bench::run_workload<Fenwik<int64>>("Fenwik", w, ops, increment, sum_query);
+				bench::run_workload<SumST<int64>>("SumST", w, ops, point_add, sum_query);
+			}
+			if (size <= NaiveMaxSize)
+			{
+				bench::run_workload<AwesomeArray<int64>>("AwesomeArray", w, ops, range_add, sum_query);
+			}
+		}
+	}
+}
+
+void BenchBlockedFenwik()
+{
+	using bench::operation;
+	auto increment = [](auto& t, const operation& op) { t.increment(op.l, op.val); };
+	auto prefix_query = [](auto& t, const operation& op) { return t.sum(op.r); };
+
+	for (int size : { 1 << 20, 1 << 24, 1 << 28 })
+	{
+		for (int update_percent : { 10, 50 })
+		{
+			bench::workload w{ "point_updates_" + to_string(update_percent), size, 4 * BenchOps, update_percent, size, 0, true };
+			auto ops = bench::generate(w);
+
+			bench::run_workload<Fenwik<int>>("Fenwik", w, ops, increment, prefix_query);
+			bench::run_workload<BlockedFenwik<int>>("BlockedFenwik", w, ops, increment, prefix_query);
+		}
+	}
+}
+
+// increments from 1, 2, 4, ... threads, up to twice the hardware threads
+void BenchConcurrentFenwik()
+{
+	using fenwik_type = ConcurrentFenwik<int64>;
+	static const int Size = 1 << 20;
+	int maxThreads = 2 * std::max<int>(1, std::thread::hardware_concurrency());
+
+	for (auto m : { fenwik_type::mode::atomic, fenwik_type::mode::sharded })
+	{
+		string name = (m == fenwik_type::mode::atomic ? "ConcurrentFenwik.atomic" : "ConcurrentFenwik.sharded");
+		for (int threads = 1; threads <= maxThreads; threads *= 2)
+		{
+			fenwik_type t;
+			t.assign(Size, m);
+
+			double seconds = bench::measure([&]()
+			{
+				vector<std::thread> workers;
+				forn(k, threads)
+				{
+					workers.emplace_back([&t, k]()
+					{
+						mt19937 rnd(k);
+						forn(i, BenchOps) t.increment(rnd() % Size, 1);
+					});
+				}
+				for (auto& w : workers) w.join();
+			});
+			bench::consume(t.sum(Size - 1));
+			bench::report(name + ".threads" + to_string(threads), Size, int64(threads) * BenchOps, seconds);
+		}
+	}
+}
+
+// min queries from 1, 2, 4, ... reader threads, up to twice the hardware threads,
+// alone and next to a writer adding to random points until the readers are done
+void BenchConcurrentSegmentTree()
+{
+	static const int Size = 1 << 20;
+	int maxThreads = 2 * std::max<int>(1, std::thread::hardware_concurrency());
+
+	for (bool writer : { false, true })
+	{
+		string name = (writer ? "ConcurrentAddMinST.min_with_writer" : "ConcurrentAddMinST.min");
+		for (int threads = 1; threads <= maxThreads; threads *= 2)
+		{
+			ConcurrentAddMinST<int> t;
+			t.assign(Size, 0);
+
+			atomic<bool> done(false);
+			std::thread adder;
+			if (writer)
+			{
+				adder = std::thread([&]()
+				{
+					mt19937 rnd(1);
+					while (!done.load())
+					{
+						int p = rnd() % Size;
+						t.add(p, p, 1);
+					}
+				});
+			}
+
+			atomic<int64> acc(0);
+			double seconds = bench::measure([&]()
+			{
+				vector<std::thread> readers;
+				forn(k, threads)
+				{
+					readers.emplace_back([&t, &acc, k]()
+					{
+						mt19937 rnd(k);
+						int64 local = 0;
+						forn(i, BenchOps)
+						{
+							int l = rnd() % Size, r = rnd() % Size;
+							if (l > r) swap(l, r);
+							local += t.min(l, r).second;
+						}
+						acc += local;
+					});
+				}
+				for (auto& r : readers) r.join();
+			});
+			done = true;
+			if (writer) adder.join();
+			bench::consume(acc.load());
+			bench::report(name + ".threads" + to_string(threads), Size, int64(threads) * BenchOps, seconds);
+		}
+	}
+}
+
+// mean depth of the nodes of t, the root has depth 1, 2 ln n - O(1) for a random treap
+double TreapAverageDepth(const Treap& treap, int t)
+{
+	if (!t) return 0;
+	int64 total = 0;
+	vector<pii> st{ { t, 1 } };
+	while (!st.empty())
+	{
+		pii cur = st.back();
+		st.pop_back();
+		total += cur.second;
+		const auto& n = treap.nodes[cur.first];
+		if (n.l) st.emplace_back(n.l, cur.second + 1);
+		if (n.r) st.emplace_back(n.r, cur.second + 1);
+	}
+	return double(total) / treap.sizeOf(t);
+}
+
+// bulk load of Size nodes, then remove and insert at random positions, the pool does not grow.
+// The workload column has the mean depth after each phase.
+void BenchTreap()
+{
+	static const int Size = 10000000;
+	mt19937 rnd(42);
+
+	Treap t;
+	t.Reserve(Size + 1);
+	int root;
+	bench::result build;
+	build.name = "Treap.from_vector";
+	build.size = build.ops = Size;
+	build.seconds = bench::measure([&]() { root = t.FromVector(vint(Size)); });
+	build.workload = "avg_depth_" + to_string(TreapAverageDepth(t, root));
+	bench::report(build);
+
+	bench::result update;
+	update.name = "Treap.remove_insert";
+	update.size = Size;
+	update.ops = 2 * BenchOps;
+	update.seconds = bench::measure([&]()
+	{
+		forn(i, BenchOps)
+		{
+			root = t.Remove(root, rnd() % Size);
+			root = t.Insert(root, t.New(), rnd() % Size);
+		}
+	});
+	bench::consume(root);
+	update.workload = "avg_depth_" + to_string(TreapAverageDepth(t, root));
+	bench::report(update);
+}
+
+// updates take turns to add, reverse and move a range, queries are sums
+void BenchLazyTreap()
+{
+	for (int size : { 1 << 16, 1 << 20 })
+	{
+		bench::workload w{ "balanced", size, BenchOps, 50, size, 0, false };
+		auto ops = bench::generate(w);
+
+		LazyTreap<int64> t;
+		int root = t.FromVector(vector<int64>(size));
+		int64 acc = 0;
+		double seconds = bench::measure([&]()
+		{
+			forn(i, ops.size())
+			{
+				const auto& op = ops[i];
+				if (!op.update) acc += t.Sum(root, op.l, op.r);
+				else if (i % 3 == 0) root = t.Add(root, op.l, op.r, op.val);
+				else if (i % 3 == 1) root = t.Reverse(root, op.l, op.r);
+				else root = t.Move(root, op.l, op.r, op.l / 2);
+			}
+		});
+		bench::consume(acc);
+
+		bench::result res;
+		res.name = "LazyTreap";
+		res.workload = "add_reverse_move_sum";
+		res.size = size;
+		res.ops = ops.size();
+		res.seconds = seconds;
+		bench::report(res);
+	}
+}
+
+// set operations of Size random keys with Size / ratio others, on one thread and on all of them
+void BenchTreapSet()
+{
+	static const int Size = 1 << 22;
+	mt19937 rnd(42);
+
+	for (int ratio : { 1, 64 })
+	{
+		vint a(Size), b(Size / ratio);
+		for (auto& x : a) x = rnd() % (4 * Size);
+		for (auto& x : b) x = rnd() % (4 * Size);
+		for (auto v : { &a, &b })
+		{
+			sort(all(*v));
+			v->erase(unique(all(*v)), v->end());
+		}
+
+		vint threadCounts{ 1 };
+		if (TreapSet<int>::Threads() > 1) threadCounts.push_back(TreapSet<int>::Threads());
+		for (int threads : threadCounts)
+		{
+			string suffix = ".ratio" + to_string(ratio) + ".threads" + to_string(threads);
+			forn(op, 3)
+			{
+				TreapSet<int> t;
+				int ra = t.FromSorted(a), rb = t.FromSorted(b);
+				int res;
+				double seconds = bench::measure([&]()
+				{
+					if (op == 0) res = t.Union(ra, rb, threads);
+					else if (op == 1) res = t.Intersect(ra, rb, threads);
+					else res = t.Difference(ra, rb, threads);
+				});
+				bench::consume(res);
+				const char* names[] = { "TreapSet.union", "TreapSet.intersect", "TreapSet.difference" };
+				bench::report(names[op] + suffix, a.size(), a.size() + b.size(), seconds);
+			}
+		}
+	}
+}
+
+auto benchPub = bench::publish(
+	BenchWideSegmentTree,
+	BenchRangeQueries,
+	BenchBlockedFenwik,
+	BenchConcurrentFenwik,
+	BenchConcurrentSegmentTree,
+	BenchTreap,
+	BenchLazyTreap,
+	BenchTreapSet
+);
@@ -0,0 +1,391 @@
+#include "Treap.h"
+#include "_tests.h"
+
+
+// node indices of the tree t, in order
+template<typename TPool>
+vint TreapNodes(const TPool& pool, int t)
+{
+	vint res, st;
+	while (t || !st.empty())
+	{
+		for (; t; t = pool.nodes[t].l) st.push_back(t);
+		t = st.back();
+		st.pop_back();
+		res.push_back(t);
+		t = pool.nodes[t].r;
+	}
+	return res;
+}
+
+// A deleted subtree is handed out again node by node before the pool grows,
+// and never a node that is still in a live tree.
+void TestTreap1()
+{
+	Treap t;
+	int root = t.FromVector(vint(100));
+	int l, m, r;
+	t.Split(root, l, m, 30);
+	t.Split(m, m, r, 40);
+
+	vint freed = TreapNodes(t, m);
+	vint live = TreapNodes(t, l), right = TreapNodes(t, r);
+	live.insert(live.end(), all(right));
+	t.Delete(m);
+
+	int poolSize = t.nodes.size();
+	vint reused;
+	forn(i, freed.size())
+	{
+		int nt = t.New();
+		test::assert_equal(1, t.sizeOf(nt));
+		test::assert_equal(0, t.nodes[nt].l + t.nodes[nt].r);
+		reused.push_back(nt);
+	}
+	test::assert_equal(poolSize, int(t.nodes.size()));
+
+	sort(all(freed));
+	sort(all(reused));
+	test::assert_bool(freed == reused);
+	for (int nt : reused) test::assert_bool(find(all(live), nt) == live.end());
+
+	test::assert_equal(poolSize, t.New());
+	test::assert_equal(poolSize + 1, int(t.nodes.size()));
+
+	// the reused nodes make a valid tree again
+	root = t.Merge(l, r);
+	for (int nt : reused) root = t.Insert(root, nt, t.sizeOf(root) / 2);
+	test::assert_equal(100, t.sizeOf(root));
+	test::assert_equal(100, int(TreapNodes(t, root).size()));
+}
+
+
+// heap order of the priorities and the sizes of all nodes of t
+template<typename TPool>
+void CheckTreap(const TPool& pool, int t)
+{
+	for (int v : TreapNodes(pool, t))
+	{
+		const auto& n = pool.nodes[v];
+		test::assert_bool(!n.l || pool.nodes[n.l].y <= n.y);
+		test::assert_bool(!n.r || pool.nodes[n.r].y <= n.y);
+		test::assert_equal(1 + pool.sizeOf(n.l) + pool.sizeOf(n.r), n.size);
+	}
+}
+
+// Random Insert and Remove against a vector, the priorities serve as the values.
+void TestTreap2()
+{
+	mt19937 rnd(20);
+	Treap t(20);
+	int root = 0;
+	vector<unsigned> exp;
+	forn(i, 3000)
+	{
+		if (exp.empty() || rnd() % 3 != 0)
+		{
+			int index = rnd() % (exp.size() + 1);
+			int nt = t.New();
+			exp.insert(exp.begin() + index, t.nodes[nt].y);
+			root = t.Insert(root, nt, index);
+		}
+		else
+		{
+			int index = rnd() % exp.size();
+			exp.erase(exp.begin() + index);
+			root = t.Remove(root, index);
+		}
+
+		test::assert_equal(int(exp.size()), t.sizeOf(root));
+		if (i % 100 == 0)
+		{
+			CheckTreap(t, root);
+			vector<unsigned> act;
+			t.ToVector(root, act);
+			test::assert_bool(exp == act);
+		}
+	}
+}
+
+// The linear build keeps the given order and makes a heap of the priorities,
+// also for sorted and repeated priorities and after other nodes in the pool.
+void TestTreap3()
+{
+	mt19937 rnd(21);
+	Treap t(21);
+	int other = t.FromVector(vint(10));
+
+	vector<vector<unsigned>> cases{ {}, { 5 }, { 1, 2, 3, 4, 5, 6 }, { 6, 5, 4, 3, 2, 1 }, { 7, 7, 7, 7 }, { 3, 1, 3, 1, 2 } };
+	vector<unsigned> random(1000);
+	for (auto& y : random) y = rnd() % 100;
+	cases.push_back(random);
+
+	for (const auto& ys : cases)
+	{
+		int root = t.FromPriorities(ys);
+		test::assert_equal(int(ys.size()), t.sizeOf(root));
+		CheckTreap(t, root);
+		vector<unsigned> act;
+		t.ToVector(root, act);
+		test::assert_bool(ys == act);
+	}
+
+	int root = t.FromVector(vint(777));
+	test::assert_equal(777, t.sizeOf(root));
+	CheckTreap(t, root);
+	test::assert_equal(10, t.sizeOf(other));
+	CheckTreap(t, other);
+}
+
+// Random edits and queries of LazyTreap against a vector.
+void TestTreap4()
+{
+	mt19937 rnd(22);
+	LazyTreap<int64> t(22);
+	vint64 exp;
+	forn(i, 20) exp.push_back(int(rnd() % 21) - 10);
+	int root = t.FromVector(exp);
+
+	forn(i, 5000)
+	{
+		int size = exp.size();
+		int l = rnd() % size, r = rnd() % size;
+		if (l > r) swap(l, r);
+		switch (rnd() % 7)
+		{
+		case 0:
+		{
+			int64 val = int(rnd() % 21) - 10;
+			for (int j = l; j <= r; ++j) exp[j] += val;
+			root = t.Add(root, l, r, val);
+			break;
+		}
+		case 1:
+			reverse(exp.begin() + l, exp.begin() + r + 1);
+			root = t.Reverse(root, l, r);
+			break;
+		case 2:
+		{
+			int index = rnd() % (size - (r - l + 1) + 1);
+			vint64 m(exp.begin() + l, exp.begin() + r + 1);
+			exp.erase(exp.begin() + l, exp.begin() + r + 1);
+			exp.insert(exp.begin() + index, all(m));
+			root = t.Move(root, l, r, index);
+			break;
+		}
+		case 3:
+		{
+			int index = rnd() % (size + 1);
+			int64 val = int(rnd() % 21) - 10;
+			exp.insert(exp.begin() + index, val);
+			root = t.Insert(root, t.New(val), index);
+			break;
+		}
+		case 4:
+			if (size == 1) break;
+			exp.erase(exp.begin() + l);
+			root = t.Remove(root, l);
+			break;
+		case 5:
+			test::assert_equal(accumulate(exp.begin() + l, exp.begin() + r + 1, int64(0)), t.Sum(root, l, r));
+			break;
+		default:
+			test::assert_equal(*min_element(exp.begin() + l, exp.begin() + r + 1), t.Min(root, l, r));
+			break;
+		}
+
+		test::assert_equal(int(exp.size()), t.sizeOf(root));
+		if (i % 100 == 0)
+		{
+			vint64 act;
+			t.ToVector(root, act);
+			test::assert_bool(exp == act);
+		}
+	}
+}
+
+// Every edit starts from a random older version, all versions must keep their contents,
+// also after Release of part of them.
+void TestTreap5()
+{
+	mt19937 rnd(23);
+	PersistentTreap<int> t(23);
+	vint versions;
+	vector<vint> exp;
+	auto add = [&](int root, const vint& v)
+	{
+		versions.push_back(root);
+		exp.push_back(v);
+	};
+	auto check = [&]()
+	{
+		forn(k, versions.size())
+		{
+			vint act;
+			t.ToVector(versions[k], act);
+			test::assert_bool(exp[k] == act);
+			if (!act.empty())
+			{
+				int index = rnd() % act.size();
+				test::assert_equal(exp[k][index], t.Get(versions[k], index));
+			}
+		}
+	};
+
+	vint v(30);
+	iota(all(v), 0);
+	add(t.FromVector(v), v);
+
+	forn(i, 600)
+	{
+		int k = rnd() % versions.size();
+		int root = versions[k];
+		vint cur = exp[k];
+		int size = cur.size();
+		int index = rnd() % (size + 1);
+		switch (rnd() % 6)
+		{
+		case 0:
+			if (!size) break;
+			index %= size;
+			cur[index] = 1000 + i;
+			add(t.Set(root, index, cur[index]), cur);
+			break;
+		case 1:
+			cur.insert(cur.begin() + index, 2000 + i);
+			add(t.Insert(root, index, cur[index]), cur);
+			break;
+		case 2:
+			if (!size) break;
+			index %= size;
+			cur.erase(cur.begin() + index);
+			add(t.Remove(root, index), cur);
+			break;
+		case 3:
+		{
+			if (!size) break;
+			int l = rnd() % size, r = rnd() % size;
+			if (l > r) swap(l, r);
+			add(t.Substr(root, l, r), vint(cur.begin() + l, cur.begin() + r + 1));
+			break;
+		}
+		case 4:
+		{
+			int a, b;
+			t.Split(root, a, b, index);
+			add(a, vint(cur.begin(), cur.begin() + index));
+			add(b, vint(cur.begin() + index, cur.end()));
+			break;
+		}
+		default:
+		{
+			// with itself or another version
+			int other = rnd() % versions.size();
+			vint merged = cur;
+			merged.insert(merged.end(), all(exp[other]));
+			if (merged.size() > 200) break;
+			add(t.Merge(root, versions[other]), merged);
+			break;
+		}
+		}
+
+		if (i % 50 == 0) check();
+		if (i % 200 == 199)
+		{
+			vint keep;
+			vector<vint> keepExp;
+			forn(j, versions.size())
+			{
+				if (rnd() % 3 != 0) continue;
+				keep.push_back(versions[j]);
+				keepExp.push_back(exp[j]);
+			}
+			keep.push_back(versions.back());
+			keepExp.push_back(exp.back());
+			t.Release(keep);
+			versions = keep;
+			exp = keepExp;
+			check();
+		}
+	}
+	check();
+}
+
+// Set operations against std::set, from small sets up to sizes past SerialSize,
+// on one thread and on several, so both the serial and the forked recursion run.
+void TestTreap6()
+{
+	mt19937 rnd(24);
+	for (auto sizes : { pii(0, 5), pii(10, 1000), pii(40000, 30000), pii(50000, 300) })
+	{
+		for (int threads : { 1, 4 })
+		{
+			TreapSet<int> t(24);
+			set<int> exp[2];
+			int roots[2] = {};
+			forn(k, 2)
+			{
+				int size = k ? sizes.second : sizes.first;
+				while (int(exp[k].size()) < size) exp[k].insert(rnd() % (3 * size));
+				roots[k] = t.FromSorted(vint(all(exp[k])));
+			}
+
+			auto check = [&](int root, const set<int>& keys)
+			{
+				test::assert_equal(int(keys.size()), t.sizeOf(root));
+				vint act;
+				t.ToVector(root, act);
+				test::assert_bool(vint(all(keys)) == act);
+				for (int k : { 0, 1, 7, 100 }) test::assert_equal(keys.count(k) > 0, t.Contains(root, k));
+			};
+
+			set<int> united = exp[0], common, rest;
+			united.insert(all(exp[1]));
+			set_intersection(all(exp[0]), all(exp[1]), inserter(common, common.end()));
+			set_difference(all(exp[0]), all(exp[1]), inserter(rest, rest.end()));
+
+			// the operations consume their arguments, so every one gets fresh copies
+			auto copies = [&]()
+			{
+				forn(k, 2) roots[k] = t.FromSorted(vint(all(exp[k])));
+			};
+			int root = t.Union(roots[0], roots[1], threads);
+			check(root, united);
+			copies();
+			root = t.Intersect(roots[0], roots[1], threads);
+			check(root, common);
+			copies();
+			root = t.Intersect(roots[1], roots[0], threads);
+			check(root, common);
+			copies();
+			root = t.Difference(roots[0], roots[1], threads);
+			check(root, rest);
+
+			// the freed nodes come back through Insert
+			forn(i, 1000)
+			{
+				int key = rnd() % 100;
+				if (rnd() % 2)
+				{
+					rest.insert(key);
+					root = t.Insert(root, key);
+				}
+				else
+				{
+					rest.erase(key);
+					root = t.Erase(root, key);
+				}
+			}
+			check(root, rest);
+		}
+	}
+}
+
+auto treapTestsPub = tests::publish(
+	TestTreap1,
+	TestTreap2,
+	TestTreap3,
+	TestTreap4,
+	TestTreap5,
+	TestTreap6
+);
@@ -1,97 +1,1011 @@
 #pragma once
 #include "header.h"
 
-struct Treap
+inline uint64 splitmix64(uint64 &seed)
 {
-	int _size;
-	static int sizeOf(const Treap *t)
+	uint64 z = (seed += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+// Node pool of the treaps: nodes live in one array and refer to each other by index,
+// 0 is the empty tree. Removed subtrees go to a free list in O(1) and New takes their nodes one by one,
+// so once the pool has grown to the working size inserts and removes allocate nothing.
+// TNode has l, r, y and size, a value initialized TNode is the empty tree.
+// Merge and Split by count walk down in a loop and fix the sizes on the way down,
+// the depth is not bounded by the call stack.
+template<typename TNode>
+struct TreapPool
+{
+	vector<TNode> nodes;
+	vint freed;
+	uint64 seed;
+
+	TreapPool(uint64 seed) : nodes(1, TNode()), seed(seed)
+	{ }
+
+	// high half of splitmix64, 32 bits keep the node in 16 bytes
+	unsigned Priority()
 	{
-		return t ? t->_size : 0;
+		return splitmix64(seed) >> 32;
 	}
 
-	Treap *l, *r;
-	int y;
+	// room for n nodes without reallocation
+	void Reserve(int n)
+	{
+		nodes.reserve(n + 1);
+	}
 
-	Treap() : l(0), r(0), y((rand() << 0xf) ^ rand()), _size(1)
-	{ }
-	Treap(Treap *base, Treap *l, Treap *r) : l(l), r(r), y(base->y), _size(1)
+	int sizeOf(int t) const
 	{
-		_size += sizeOf(l) + sizeOf(r);
-		delete base;
-	}	
+		return nodes[t].size;
+	}
 
-	static Treap* Merge(Treap *l, Treap *r)
+	// a leaf with a fresh priority
+	int New()
 	{
-		if (!l) return r;
-		if (!r) return l;
-		if (l->y > r->y)
+		TNode n = TNode();
+		n.y = Priority();
+		n.size = 1;
+		if (freed.empty())
 		{
-			return new Treap(l, l->l, Merge(l->r, r));
+			nodes.push_back(n);
+			return nodes.size() - 1;
 		}
-		else
-		{		
-			return new Treap(r, Merge(l, r->l), r->r);
+		int t = freed.back();
+		freed.pop_back();
+		if (nodes[t].l) freed.push_back(nodes[t].l);
+		if (nodes[t].r) freed.push_back(nodes[t].r);
+		nodes[t] = n;
+		return t;
+	}
+
+	void Delete(int t)
+	{
+		freed.push_back(t);
+	}
+
+	// O(n) Cartesian tree build of count leaves at base with their priorities set, in order.
+	// The right spine is kept on a stack, a node leaving it has its subtree complete and goes to recalc.
+	template<typename TRecalc>
+	int Build(int base, int count, TRecalc recalc)
+	{
+		vint spine;
+		for (int t = base; t < base + count; t++)
+		{
+			int last = 0;
+			while (!spine.empty() && nodes[spine.back()].y < nodes[t].y)
+			{
+				last = spine.back();
+				spine.pop_back();
+				recalc(last);
+			}
+			nodes[t].l = last;
+			nodes[t].r = 0;
+			if (!spine.empty()) nodes[spine.back()].r = t;
+			spine.push_back(t);
 		}
+
+		int root = 0;
+		while (!spine.empty())
+		{
+			root = spine.back();
+			spine.pop_back();
+			recalc(root);
+		}
+		return root;
 	}
 
-	void Split(Treap *&l, Treap *&r, int count)
+	int Merge(int l, int r)
 	{
-		Treap *nt;
-		l = r = nt = 0;
-		int leftCount = sizeOf(this->l);
-		if (count <= leftCount)
+		int res;
+		int *hole = &res;
+		while (l && r)
 		{
-			if (this->l) this->l->Split(l, nt, count);
-			r = new Treap(this, nt, this->r);
+			if (nodes[l].y > nodes[r].y)
+			{
+				*hole = l;
+				nodes[l].size += nodes[r].size;
+				hole = &nodes[l].r;
+				l = nodes[l].r;
+			}
+			else
+			{
+				*hole = r;
+				nodes[r].size += nodes[l].size;
+				hole = &nodes[r].l;
+				r = nodes[r].l;
+			}
 		}
-		else
-		{		
-			if (this->r) this->r->Split(nt, r, count - leftCount - 1);
-			l = new Treap(this, this->l, nt);
+		*hole = l ? l : r;
+		return res;
+	}
+
+	// first count nodes of t to l, the rest to r
+	void Split(int t, int &l, int &r, int count)
+	{
+		int *lHole = &l, *rHole = &r;
+		while (t)
+		{
+			TNode &n = nodes[t];
+			int leftCount = sizeOf(n.l);
+			if (count <= leftCount)
+			{
+				n.size -= count;
+				*rHole = t;
+				rHole = &n.l;
+				t = n.l;
+			}
+			else
+			{
+				n.size = count;
+				*lHole = t;
+				lHole = &n.r;
+				t = n.r;
+				count -= leftCount + 1;
+			}
 		}
+		*lHole = *rHole = 0;
 	}
-	
-	Treap* Insert(Treap *nt, int index)
+};
+
+
+struct TreapNode
+{
+	int l, r;
+	unsigned y;
+	int size;
+};
+
+// Implicit treap on a node pool, Split and Merge rewire the nodes in place.
+struct Treap : TreapPool<TreapNode>
+{
+	using Node = TreapNode;
+
+	Treap(uint64 seed = 0x9e3779b97f4a7c15ull) : TreapPool(seed)
+	{ }
+
+	int Insert(int t, int nt, int index)
 	{
-		Treap *l, *r;
-		Split(l, r, index);
+		int l, r;
+		Split(t, l, r, index);
 		return Merge(Merge(l, nt), r);
 	}
-	
-	Treap* Remove(int index, Treap *&removed)
+
+	int Remove(int t, int index, int &removed)
 	{
-		Treap *l, *r;
-		Split(l, r, index);
-		r->Split(removed, r, 1);
+		int l, r;
+		Split(t, l, r, index);
+		Split(r, removed, r, 1);
 		return Merge(l, r);
 	}
-	
-	Treap* Remove(int index)
+
+	int Remove(int t, int index)
+	{
+		int m;
+		t = Remove(t, index, m);
+		if (m) Delete(m);
+		return t;
+	}
+
+	// in order, with an explicit stack
+	void ToVector(int t, vector<unsigned> &v) const
+	{
+		v.reserve(v.size() + sizeOf(t));
+		vint st;
+		while (t || !st.empty())
+		{
+			for (; t; t = nodes[t].l) st.push_back(t);
+			t = st.back();
+			st.pop_back();
+			v.push_back(nodes[t].y);
+			t = nodes[t].r;
+		}
+	}
+
+	// O(n), nodes with priorities ys in order at the end of the pool
+	int FromPriorities(const vector<unsigned> &ys)
+	{
+		int base = nodes.size();
+		nodes.resize(base + ys.size(), Node());
+		for (int i = 0; i < int(ys.size()); i++)
+		{
+			nodes[base + i].y = ys[i];
+		}
+		return Build(base, ys.size(), [this](int t)
+		{
+			Node &n = nodes[t];
+			n.size = 1 + sizeOf(n.l) + sizeOf(n.r);
+		});
+	}
+
+	int FromVector(const vint &v)
+	{
+		vector<unsigned> ys(v.size());
+		for (auto &y : ys) y = Priority();
+		return FromPriorities(ys);
+	}
+};
+
+
+template<typename T>
+struct LazyTreapNode
+{
+	int l, r;
+	unsigned y;
+	int size;
+	T val, sum, min;
+	// pending for the children, the node itself is up to date
+	T add;
+	bool rev;
+};
+
+// Implicit treap with values: range add and reverse, range sum and min, cut and paste, O(log n) each.
+// Split and Merge are the ones of TreapPool, they push the tags on the way down
+// and recalc the nodes on the way back from an explicit stack. Ranges are [l, r], l <= r.
+// Queries split the treap and merge it back, so they may change the root.
+template<typename T>
+struct LazyTreap : TreapPool<LazyTreapNode<T>>
+{
+	using Node = LazyTreapNode<T>;
+	using TreapPool<Node>::nodes;
+	using TreapPool<Node>::sizeOf;
+	using TreapPool<Node>::Delete;
+
+	// nodes to recalc, deepest last
+	vint path;
+
+	LazyTreap(uint64 seed = 0x9e3779b97f4a7c15ull) : TreapPool<Node>(seed)
+	{ }
+
+	int New(T val)
+	{
+		int t = TreapPool<Node>::New();
+		Node &n = nodes[t];
+		n.val = n.sum = n.min = val;
+		return t;
+	}
+
+	void ApplyAdd(int t, T val)
+	{
+		if (!t) return;
+		Node &n = nodes[t];
+		n.val += val;
+		n.sum += val * n.size;
+		n.min += val;
+		n.add += val;
+	}
+
+	void ApplyReverse(int t)
+	{
+		if (!t) return;
+		Node &n = nodes[t];
+		swap(n.l, n.r);
+		n.rev = !n.rev;
+	}
+
+	void Push(int t)
 	{
-		Treap *l, *r, *m;
-		Split(l, r, index);
-		r->Split(m, r, 1);
-		delete m;
+		Node &n = nodes[t];
+		if (n.rev)
+		{
+			ApplyReverse(n.l);
+			ApplyReverse(n.r);
+			n.rev = false;
+		}
+		if (n.add != 0)
+		{
+			ApplyAdd(n.l, n.add);
+			ApplyAdd(n.r, n.add);
+			n.add = 0;
+		}
+	}
+
+	void Recalc(int t)
+	{
+		Node &n = nodes[t];
+		n.size = 1;
+		n.sum = n.min = n.val;
+		for (int c : { n.l, n.r })
+		{
+			if (!c) continue;
+			n.size += nodes[c].size;
+			n.sum += nodes[c].sum;
+			n.min = std::min(n.min, nodes[c].min);
+		}
+	}
+
+	void RecalcPath()
+	{
+		while (!path.empty())
+		{
+			Recalc(path.back());
+			path.pop_back();
+		}
+	}
+
+	int Merge(int l, int r)
+	{
+		int res;
+		int *hole = &res;
+		while (l && r)
+		{
+			if (nodes[l].y > nodes[r].y)
+			{
+				Push(l);
+				*hole = l;
+				path.push_back(l);
+				hole = &nodes[l].r;
+				l = nodes[l].r;
+			}
+			else
+			{
+				Push(r);
+				*hole = r;
+				path.push_back(r);
+				hole = &nodes[r].l;
+				r = nodes[r].l;
+			}
+		}
+		*hole = l ? l : r;
+		RecalcPath();
+		return res;
+	}
+
+	// first count nodes of t to l, the rest to r
+	void Split(int t, int &l, int &r, int count)
+	{
+		int *lHole = &l, *rHole = &r;
+		while (t)
+		{
+			Push(t);
+			path.push_back(t);
+			Node &n = nodes[t];
+			int leftCount = sizeOf(n.l);
+			if (count <= leftCount)
+			{
+				*rHole = t;
+				rHole = &n.l;
+				t = n.l;
+			}
+			else
+			{
+				*lHole = t;
+				lHole = &n.r;
+				t = n.r;
+				count -= leftCount + 1;
+			}
+		}
+		*lHole = *rHole = 0;
+		RecalcPath();
+	}
+
+	int Insert(int t, int nt, int index)
+	{
+		int l, r;
+		Split(t, l, r, index);
+		return Merge(Merge(l, nt), r);
+	}
+
+	int Remove(int t, int index, int &removed)
+	{
+		int l, r;
+		Split(t, l, r, index);
+		Split(r, removed, r, 1);
 		return Merge(l, r);
 	}
 
-	void ToVector(vint &v)
+	int Remove(int t, int index)
 	{
-		if (l) l->ToVector(v);
-		v.push_back(y);
-		if (r) r->ToVector(v);
+		int m;
+		t = Remove(t, index, m);
+		if (m) Delete(m);
+		return t;
 	}
 
-	static Treap* FromVector(const vint &v)
+	// [l, r] of t to m, the rest to a and b
+	void Cut(int t, int &a, int &m, int &b, int l, int r)
 	{
-		if (v.empty()) return 0;
-		Treap *t = new Treap(/*v[0]*/);
-		for(int i = 1; i < v.size(); i++)
+		Split(t, a, m, l);
+		Split(m, m, b, r - l + 1);
+	}
+
+	int Add(int t, int l, int r, T val)
+	{
+		int a, m, b;
+		Cut(t, a, m, b, l, r);
+		ApplyAdd(m, val);
+		return Merge(Merge(a, m), b);
+	}
+
+	int Reverse(int t, int l, int r)
+	{
+		int a, m, b;
+		Cut(t, a, m, b, l, r);
+		ApplyReverse(m);
+		return Merge(Merge(a, m), b);
+	}
+
+	// cuts [l, r] out and pastes it at index of the rest
+	int Move(int t, int l, int r, int index)
+	{
+		int a, m, b;
+		Cut(t, a, m, b, l, r);
+		Split(Merge(a, b), a, b, index);
+		return Merge(Merge(a, m), b);
+	}
+
+	// Sum and Min cut [l, r] out and merge the treap back, so they write to the nodes
+	// and update the root t, it may differ afterwards.
+	T Sum(int &t, int l, int r)
+	{
+		int a, m, b;
+		Cut(t, a, m, b, l, r);
+		T res = nodes[m].sum;
+		t = Merge(Merge(a, m), b);
+		return res;
+	}
+
+	T Min(int &t, int l, int r)
+	{
+		int a, m, b;
+		Cut(t, a, m, b, l, r);
+		T res = nodes[m].min;
+		t = Merge(Merge(a, m), b);
+		return res;
+	}
+
+	// in order, with an explicit stack
+	void ToVector(int t, vector<T> &v)
+	{
+		v.reserve(v.size() + sizeOf(t));
+		vint st;
+		while (t || !st.empty())
+		{
+			for (; t; t = nodes[t].l)
+			{
+				Push(t);
+				st.push_back(t);
+			}
+			t = st.back();
+			st.pop_back();
+			v.push_back(nodes[t].val);
+			t = nodes[t].r;
+		}
+	}
+
+	// O(n), at the end of the pool
+	int FromVector(const vector<T> &v)
+	{
+		int base = nodes.size();
+		nodes.resize(base + v.size(), Node());
+		for (int i = 0; i < int(v.size()); i++)
 		{
-			t = Merge(t, new Treap(/*v[i]*/));
+			Node &n = nodes[base + i];
+			n.y = this->Priority();
+			n.val = v[i];
 		}
+		return this->Build(base, v.size(), [this](int t) { Recalc(t); });
+	}
+};
+
+
+
+template<typename T>
+struct TreapSetNode
+{
+	int l, r;
+	unsigned y;
+	int size;
+	T key;
+};
+
+// Ordered set of distinct keys. Union, Intersect and Difference are join based,
+// O(m log(n / m + 1)) for sets of sizes m <= n, and consume their arguments:
+// the nodes they leave out go back to the pool in O(1) each.
+// The two halves of the recursion run on up to threads threads, as in segment_tree::build_parallel.
+template<typename T>
+struct TreapSet : TreapPool<TreapSetNode<T>>
+{
+	using Node = TreapSetNode<T>;
+	using TreapPool<Node>::nodes;
+	using TreapPool<Node>::sizeOf;
+	using TreapPool<Node>::Merge;
+	using TreapPool<Node>::Delete;
+
+	TreapSet(uint64 seed = 0x9e3779b97f4a7c15ull) : TreapPool<Node>(seed)
+	{ }
+
+private:
+	static const int SerialSize = 1 << 14;
+
+	void Update(int t)
+	{
+		Node &n = nodes[t];
+		n.size = 1 + sizeOf(n.l) + sizeOf(n.r);
+	}
+
+	// Runs left and right, with the left one on another thread if there are threads to spare.
+	// They get their shares of the threads and a list for the nodes to delete.
+	template<typename TLeft, typename TRight>
+	static void Fork(int threads, int size, vint &trash, TLeft left, TRight right)
+	{
+		if (threads <= 1 || size <= SerialSize)
+		{
+			left(1, trash);
+			right(1, trash);
+			return;
+		}
+
+		vint leftTrash;
+		auto f = std::async(std::launch::async, [&]()
+		{
+			left(threads / 2, leftTrash);
+		});
+		right(threads - threads / 2, trash);
+		f.get();
+		trash.insert(trash.end(), all(leftTrash));
+	}
+
+	int unite(int a, int b, int threads, vint &trash)
+	{
+		if (!a || !b) return a ? a : b;
+		// a has the highest priority of both, so it stays the root
+		if (nodes[a].y < nodes[b].y) swap(a, b);
+
+		int l, dup, r;
+		SplitKey(b, nodes[a].key, l, dup, r);
+		if (dup) trash.push_back(dup);
+
+		Node &n = nodes[a];
+		Fork(threads, sizeOf(a) + sizeOf(b), trash,
+			[&](int th, vint &tr) { n.l = unite(n.l, l, th, tr); },
+			[&](int th, vint &tr) { n.r = unite(n.r, r, th, tr); });
+		Update(a);
+		return a;
+	}
+
+	int intersect(int a, int b, int threads, vint &trash)
+	{
+		if (!a || !b)
+		{
+			if (a || b) trash.push_back(a ? a : b);
+			return 0;
+		}
+		if (nodes[a].y < nodes[b].y) swap(a, b);
+
+		int l, dup, r;
+		SplitKey(b, nodes[a].key, l, dup, r);
+
+		Node &n = nodes[a];
+		int resL, resR;
+		Fork(threads, sizeOf(a) + sizeOf(b), trash,
+			[&](int th, vint &tr) { resL = intersect(n.l, l, th, tr); },
+			[&](int th, vint &tr) { resR = intersect(n.r, r, th, tr); });
+
+		if (dup)
+		{
+			trash.push_back(dup);
+			n.l = resL;
+			n.r = resR;
+			Update(a);
+			return a;
+		}
+		n.l = n.r = 0;
+		trash.push_back(a);
+		return Merge(resL, resR);
+	}
+
+	int difference(int a, int b, int threads, vint &trash)
+	{
+		if (!a || !b)
+		{
+			if (b) trash.push_back(b);
+			return a;
+		}
+
+		int l, dup, r;
+		SplitKey(a, nodes[b].key, l, dup, r);
+		if (dup) trash.push_back(dup);
+
+		Node &n = nodes[b];
+		int resL, resR;
+		Fork(threads, sizeOf(a) + sizeOf(b), trash,
+			[&](int th, vint &tr) { resL = difference(l, n.l, th, tr); },
+			[&](int th, vint &tr) { resR = difference(r, n.r, th, tr); });
+		n.l = n.r = 0;
+		trash.push_back(b);
+		return Merge(resL, resR);
+	}
+
+	template<typename TOperation>
+	int Run(TOperation op, int a, int b, int threads)
+	{
+		vint trash;
+		int res = (this->*op)(a, b, threads, trash);
+		for (int t : trash) Delete(t);
+		return res;
+	}
+
+public:
+	static int Threads()
+	{
+		return std::max<int>(1, std::thread::hardware_concurrency());
+	}
+
+	int New(const T &key)
+	{
+		int t = TreapPool<Node>::New();
+		nodes[t].key = key;
 		return t;
 	}
 
+	// keys of t less than k to l, greater to r, the node of k or 0 to dup.
+	// The rank of k turns it into Split by count, which fixes the sizes on the way down.
+	void SplitKey(int t, const T &k, int &l, int &dup, int &r)
+	{
+		int less = 0;
+		bool found = false;
+		for (int c = t; c; )
+		{
+			const Node &n = nodes[c];
+			if (k < n.key)
+			{
+				c = n.l;
+			}
+			else if (n.key < k)
+			{
+				less += sizeOf(n.l) + 1;
+				c = n.r;
+			}
+			else
+			{
+				less += sizeOf(n.l);
+				found = true;
+				break;
+			}
+		}
+		this->Split(t, l, r, less);
+		dup = 0;
+		if (found) this->Split(r, dup, r, 1);
+	}
+
+	bool Contains(int t, const T &k) const
+	{
+		while (t)
+		{
+			const Node &n = nodes[t];
+			if (k < n.key) t = n.l;
+			else if (n.key < k) t = n.r;
+			else return true;
+		}
+		return false;
+	}
+
+	int Insert(int t, const T &key)
+	{
+		int l, dup, r;
+		SplitKey(t, key, l, dup, r);
+		return Merge(Merge(l, dup ? dup : New(key)), r);
+	}
+
+	int Erase(int t, const T &key)
+	{
+		int l, dup, r;
+		SplitKey(t, key, l, dup, r);
+		if (dup) Delete(dup);
+		return Merge(l, r);
+	}
+
+	int Union(int a, int b, int threads = Threads())
+	{
+		return Run(&TreapSet::unite, a, b, threads);
+	}
+
+	int Intersect(int a, int b, int threads = Threads())
+	{
+		return Run(&TreapSet::intersect, a, b, threads);
+	}
+
+	// keys of a not in b
+	int Difference(int a, int b, int threads = Threads())
+	{
+		return Run(&TreapSet::difference, a, b, threads);
+	}
+
+	// O(n), keys sorted and distinct, at the end of the pool
+	int FromSorted(const vector<T> &keys)
+	{
+		int base = nodes.size();
+		nodes.resize(base + keys.size(), Node());
+		for (int i = 0; i < int(keys.size()); i++)
+		{
+			Node &n = nodes[base + i];
+			n.y = this->Priority();
+			n.key = keys[i];
+		}
+		return this->Build(base, keys.size(), [this](int t) { Update(t); });
+	}
+
+	// in order, with an explicit stack
+	void ToVector(int t, vector<T> &v) const
+	{
+		v.reserve(v.size() + sizeOf(t));
+		vint st;
+		while (t || !st.empty())
+		{
+			for (; t; t = nodes[t].l) st.push_back(t);
+			t = st.back();
+			st.pop_back();
+			v.push_back(nodes[t].key);
+			t = nodes[t].r;
+		}
+	}
 };
 
+template<typename T>
+struct PersistentTreapNode
+{
+	int l, r;
+	int size;
+	// the operation that created the node
+	int stamp;
+	T val;
+};
+
+// Persistent implicit treap (rope). Nodes of all versions live in one arena, a version is the index
+// of its root, so a snapshot is an int. Every edit gets a new stamp, a node is changed in place only
+// by the edit that created it, other nodes are copied on the way down: O(log n) new nodes per edit
+// and the versions share the rest. There are no priorities, Merge takes the root of l or r
+// with probability proportional to their sizes, so a version may be merged with itself.
+// Release drops all versions but the kept ones at once.
+template<typename T>
+struct PersistentTreap
+{
+	using Node = PersistentTreapNode<T>;
+
+	vector<Node> nodes;
+	uint64 seed;
+	int stamp;
+
+	PersistentTreap(uint64 seed = 0x9e3779b97f4a7c15ull) : nodes(1, Node()), seed(seed), stamp(0)
+	{ }
+
+	int sizeOf(int t) const
+	{
+		return nodes[t].size;
+	}
+
+	// nodes allocated for all versions
+	int count() const
+	{
+		return nodes.size() - 1;
+	}
+
+private:
+	int New(const T &val)
+	{
+		nodes.push_back(Node{ 0, 0, 1, stamp, val });
+		return nodes.size() - 1;
+	}
+
+	// t itself if the current edit created it, a copy otherwise
+	int Own(int t)
+	{
+		if (nodes[t].stamp == stamp) return t;
+		Node n = nodes[t];
+		n.stamp = stamp;
+		nodes.push_back(n);
+		return nodes.size() - 1;
+	}
+
+	// the pool may grow on the way, so the last nodes of both sides are kept by index
+	void split(int t, int &l, int &r, int count)
+	{
+		int lLast = 0, rLast = 0;
+		l = r = 0;
+		while (t)
+		{
+			t = Own(t);
+			Node &n = nodes[t];
+			int leftCount = sizeOf(n.l);
+			if (count <= leftCount)
+			{
+				n.size -= count;
+				(rLast ? nodes[rLast].l : r) = t;
+				rLast = t;
+				t = n.l;
+			}
+			else
+			{
+				n.size = count;
+				(lLast ? nodes[lLast].r : l) = t;
+				lLast = t;
+				t = n.r;
+				count -= leftCount + 1;
+			}
+		}
+		if (lLast) nodes[lLast].r = 0;
+		if (rLast) nodes[rLast].l = 0;
+	}
+
+	int merge(int l, int r)
+	{
+		int res = 0, last = 0;
+		bool lastRight = false;
+		while (l && r)
+		{
+			int t;
+			bool right = splitmix64(seed) % uint64(sizeOf(l) + sizeOf(r)) < uint64(sizeOf(l));
+			if (right)
+			{
+				t = Own(l);
+				nodes[t].size += sizeOf(r);
+				l = nodes[t].r;
+			}
+			else
+			{
+				t = Own(r);
+				nodes[t].size += sizeOf(l);
+				r = nodes[t].l;
+			}
+			(!last ? res : lastRight ? nodes[last].r : nodes[last].l) = t;
+			last = t;
+			lastRight = right;
+		}
+		(!last ? res : lastRight ? nodes[last].r : nodes[last].l) = l ? l : r;
+		return res;
+	}
+
+	int build(const vector<T> &v, int lo, int hi)
+	{
+		if (lo > hi) return 0;
+		int m = (lo + hi) >> 1;
+		int t = New(v[m]);
+		int l = build(v, lo, m - 1);
+		int r = build(v, m + 1, hi);
+		Node &n = nodes[t];
+		n.l = l;
+		n.r = r;
+		n.size = hi - lo + 1;
+		return t;
+	}
+
+	int copy_from(const PersistentTreap &from, int t, vint &remap)
+	{
+		if (!t) return 0;
+		if (remap[t]) return remap[t];
+
+		Node n = from.nodes[t];
+		n.l = copy_from(from, n.l, remap);
+		n.r = copy_from(from, n.r, remap);
+		nodes.push_back(n);
+		return remap[t] = nodes.size() - 1;
+	}
+
+public:
+	// balanced version of v, O(n)
+	int FromVector(const vector<T> &v)
+	{
+		++stamp;
+		return build(v, 0, int(v.size()) - 1);
+	}
+
+	// in order, with an explicit stack
+	void ToVector(int t, vector<T> &v) const
+	{
+		v.reserve(v.size() + sizeOf(t));
+		vint st;
+		while (t || !st.empty())
+		{
+			for (; t; t = nodes[t].l) st.push_back(t);
+			t = st.back();
+			st.pop_back();
+			v.push_back(nodes[t].val);
+			t = nodes[t].r;
+		}
+	}
+
+	const T& Get(int t, int index) const
+	{
+		while (true)
+		{
+			const Node &n = nodes[t];
+			int leftCount = sizeOf(n.l);
+			if (index == leftCount) return n.val;
+			if (index < leftCount)
+			{
+				t = n.l;
+			}
+			else
+			{
+				t = n.r;
+				index -= leftCount + 1;
+			}
+		}
+	}
+
+	// The rest return new versions, the arguments stay available.
+
+	int Merge(int l, int r)
+	{
+		++stamp;
+		return merge(l, r);
+	}
+
+	void Split(int t, int &l, int &r, int count)
+	{
+		++stamp;
+		split(t, l, r, count);
+	}
+
+	int Set(int t, int index, const T &val)
+	{
+		++stamp;
+		int res = t = Own(t);
+		while (true)
+		{
+			Node &n = nodes[t];
+			int leftCount = sizeOf(n.l);
+			if (index == leftCount)
+			{
+				n.val = val;
+				return res;
+			}
+			int c;
+			if (index < leftCount)
+			{
+				c = Own(n.l);
+				nodes[t].l = c;
+			}
+			else
+			{
+				c = Own(n.r);
+				nodes[t].r = c;
+				index -= leftCount + 1;
+			}
+			t = c;
+		}
+	}
+
+	int Insert(int t, int index, const T &val)
+	{
+		++stamp;
+		int l, r;
+		split(t, l, r, index);
+		return merge(merge(l, New(val)), r);
+	}
+
+	int Remove(int t, int index)
+	{
+		++stamp;
+		int l, m, r;
+		split(t, l, r, index);
+		split(r, m, r, 1);
+		return merge(l, r);
+	}
+
+	// [l, r]
+	int Substr(int t, int l, int r)
+	{
+		++stamp;
+		int a, m, b;
+		split(t, a, m, l);
+		split(m, m, b, r - l + 1);
+		return m;
+	}
+
+	// Releases all versions except keep, which are replaced by their new indices.
+	void Release(vint &keep)
+	{
+		PersistentTreap res(seed);
+		res.stamp = stamp;
+		vint remap(nodes.size(), 0);
+		for (int &root : keep)
+		{
+			root = res.copy_from(*this, root, remap);
+		}
+		*this = std::move(res);
+	}
+};
@@ -0,0 +1,338 @@
+#pragma once
+#include "header.h"
+#include <cstdint>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Read-mostly segment trees with B-ary nodes: the B keys of a node fill one cache line,
+// so a query touches at most two lines per level.
+namespace wide_segment_tree
+{
+	// Reductions over cnt > 0 consecutive keys of one node.
+	template<typename T>
+	struct sum_reduce
+	{
+		static T merge(T left, T right) { return left + right; }
+		static T reduce(const T* a, int cnt)
+		{
+			T res = a[0];
+			for (int i = 1; i < cnt; ++i) res += a[i];
+			return res;
+		}
+	};
+
+	template<typename T>
+	struct min_reduce
+	{
+		static T merge(T left, T right) { return std::min(left, right); }
+		static T reduce(const T* a, int cnt)
+		{
+			T res = a[0];
+			for (int i = 1; i < cnt; ++i) res = std::min(res, a[i]);
+			return res;
+		}
+		// first position of val, it must be present
+		static int find(const T* a, int, T val)
+		{
+			int i = 0;
+			while (a[i] != val) ++i;
+			return i;
+		}
+	};
+
+#ifdef __AVX2__
+	inline __m256i lanes_mask(int cnt)
+	{
+		return _mm256_cmpgt_epi32(_mm256_set1_epi32(cnt), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	}
+
+	template<>
+	struct sum_reduce<int>
+	{
+		static int merge(int left, int right) { return left + right; }
+		static int reduce(const int* a, int cnt)
+		{
+			__m256i s = _mm256_setzero_si256();
+			for (; cnt >= 8; a += 8, cnt -= 8)
+			{
+				s = _mm256_add_epi32(s, _mm256_loadu_si256((const __m256i*)a));
+			}
+			if (cnt > 0) s = _mm256_add_epi32(s, _mm256_maskload_epi32(a, lanes_mask(cnt)));
+
+			__m128i x = _mm_add_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+			x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)));
+			x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)));
+			return _mm_cvtsi128_si32(x);
+		}
+	};
+
+	template<>
+	struct min_reduce<int>
+	{
+		static int merge(int left, int right) { return std::min(left, right); }
+		static int reduce(const int* a, int cnt)
+		{
+			// lanes past cnt are filled with a[0]
+			__m256i m = _mm256_set1_epi32(a[0]);
+			for (; cnt >= 8; a += 8, cnt -= 8)
+			{
+				m = _mm256_min_epi32(m, _mm256_loadu_si256((const __m256i*)a));
+			}
+			if (cnt > 0)
+			{
+				__m256i mask = lanes_mask(cnt);
+				m = _mm256_min_epi32(m, _mm256_blendv_epi8(m, _mm256_maskload_epi32(a, mask), mask));
+			}
+
+			__m128i x = _mm_min_epi32(_mm256_castsi256_si128(m), _mm256_extracti128_si256(m, 1));
+			x = _mm_min_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)));
+			x = _mm_min_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)));
+			return _mm_cvtsi128_si32(x);
+		}
+		// may read up to 7 keys past cnt, the tree keeps padding for that
+		static int find(const int* a, int, int val)
+		{
+			__m256i v = _mm256_set1_epi32(val);
+			for (int i = 0; ; i += 8)
+			{
+				__m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(a + i)), v);
+				int mask = _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+				if (mask == 0) continue;
+
+				int j = 0;
+				while (!((mask >> j) & 1)) ++j;
+				return i + j;
+			}
+		}
+	};
+#endif
+
+	// Level 0 keeps the values, key j of level k + 1 is the reduction of node j of level k,
+	// i.e. keys [j*B, j*B + B) of level k. Every level is padded with zero to whole nodes.
+	template<typename T, typename TReduce>
+	class Tree
+	{
+	public:
+		static const int B = 64 / sizeof(T);
+
+	private:
+		vector<T> _buf;
+		int _align;
+		vint _offset;
+		vint _count;
+		int _size;
+		T _zero;
+
+		int node_count(int cnt) const { return (cnt + B - 1) / B; }
+
+	public:
+		int size() const { return _size; }
+		int levels() const { return _offset.size(); }
+		T zero() const { return _zero; }
+
+		const T* level(int k) const { return _buf.data() + _align + _offset[k]; }
+		T* level(int k) { return _buf.data() + _align + _offset[k]; }
+
+		void assign(int size, T zero)
+		{
+			_size = size;
+			_zero = zero;
+			_offset.clear();
+			_count.clear();
+
+			int total = 0;
+			for (int cnt = std::max(size, 1); ; cnt = node_count(cnt))
+			{
+				_offset.push_back(total);
+				_count.push_back(cnt);
+				total += node_count(cnt) * B;
+				if (cnt <= B) break;
+			}
+
+			// room for the cache line alignment and for reads past the last node
+			_buf.assign(total + 2 * B, zero);
+			_align = 0;
+			while (reinterpret_cast<uintptr_t>(_buf.data() + _align) % 64 != 0) ++_align;
+		}
+
+		// recalculates all levels above the values
+		void build()
+		{
+			for (int k = 1; k < levels(); ++k)
+			{
+				const T* a = level(k - 1);
+				T* t = level(k);
+				forn(j, _count[k])
+				{
+					t[j] = TReduce::reduce(a + j * B, B);
+				}
+			}
+		}
+
+		// recalculates the keys above value i
+		void update(int i)
+		{
+			for (int k = 1; k < levels(); ++k)
+			{
+				i /= B;
+				level(k)[i] = TReduce::reduce(level(k - 1) + i * B, B);
+			}
+		}
+
+		// for commutative reductions
+		T calc(int l, int r) const
+		{
+			T res = _zero;
+			for (int k = 0; l <= r; ++k)
+			{
+				const T* a = level(k);
+				int bl = l / B, br = r / B;
+				if (bl == br)
+				{
+					return TReduce::merge(res, TReduce::reduce(a + l, r - l + 1));
+				}
+
+				if (l % B != 0) res = TReduce::merge(res, TReduce::reduce(a + l, (bl + 1) * B - l));
+				if (r % B != B - 1) res = TReduce::merge(res, TReduce::reduce(a + br * B, r - br * B + 1));
+				l = (l % B != 0 ? bl + 1 : bl);
+				r = (r % B != B - 1 ? br - 1 : br);
+			}
+			return res;
+		}
+
+		// position of the first value val below keys [from, from + cnt) of level k
+		int find(int k, int from, int cnt, T val) const
+		{
+			int p = from + TReduce::find(level(k) + from, cnt, val);
+			while (k > 0)
+			{
+				--k;
+				p = p * B + TReduce::find(level(k) + p * B, B, val);
+			}
+			return p;
+		}
+	};
+}
+
+
+template<typename T>
+class WideSumST
+{
+	using tree_type = wide_segment_tree::Tree<T, wide_segment_tree::sum_reduce<T>>;
+	tree_type _tree;
+
+public:
+	void assign(int size, const T& val = 0)
+	{
+		_tree.assign(size, 0);
+		fill(_tree.level(0), _tree.level(0) + size, val);
+		_tree.build();
+	}
+	void assign(const vector<T>& vals)
+	{
+		_tree.assign(vals.size(), 0);
+		copy(all(vals), _tree.level(0));
+		_tree.build();
+	}
+
+	T sum(int l, int r) const
+	{
+		return _tree.calc(l, r);
+	}
+
+	void add(int i, T val)
+	{
+		_tree.level(0)[i] += val;
+		_tree.update(i);
+	}
+
+	void set(int i, T val)
+	{
+		_tree.level(0)[i] = val;
+		_tree.update(i);
+	}
+
+};
+
+
+template<typename T, T INF = T(1e9)>
+class WideMinST
+{
+	using reduce_type = wide_segment_tree::min_reduce<T>;
+	using tree_type = wide_segment_tree::Tree<T, reduce_type>;
+	static const int B = tree_type::B;
+	tree_type _tree;
+
+	struct Candidate
+	{
+		T val;
+		int level, from, cnt;
+
+		Candidate() : val(INF), level(-1) {}
+
+		void update(const tree_type& tree, int k, int l, int cnt, bool strict)
+		{
+			T m = reduce_type::reduce(tree.level(k) + l, cnt);
+			if (strict ? m < val : m <= val)
+			{
+				val = m;
+				level = k;
+				from = l;
+				this->cnt = cnt;
+			}
+		}
+	};
+
+public:
+	void assign(int size, const T& val = 0)
+	{
+		_tree.assign(size, INF);
+		fill(_tree.level(0), _tree.level(0) + size, val);
+		_tree.build();
+	}
+	void assign(const vector<T>& vals)
+	{
+		_tree.assign(vals.size(), INF);
+		copy(all(vals), _tree.level(0));
+		_tree.build();
+	}
+
+	pair<T, int> min(int l, int r) const
+	{
+		// Parts left of the topmost node come in index order and win ties,
+		// parts right of it come in reverse order and lose ties.
+		Candidate left, right;
+		for (int k = 0; l <= r; ++k)
+		{
+			int bl = l / B, br = r / B;
+			if (bl == br)
+			{
+				left.update(_tree, k, l, r - l + 1, true);
+				break;
+			}
+
+			left.update(_tree, k, l, (bl + 1) * B - l, true);
+			right.update(_tree, k, br * B, r - br * B + 1, false);
+			l = bl + 1;
+			r = br - 1;
+		}
+
+		const Candidate& best = (right.val < left.val ? right : left);
+		if (best.level < 0) return pair<T, int>(INF, -1);
+		return pair<T, int>(best.val, _tree.find(best.level, best.from, best.cnt, best.val));
+	}
+
+	void add(int i, T val)
+	{
+		_tree.level(0)[i] += val;
+		_tree.update(i);
+	}
+
+	void set(int i, T val)
+	{
+		_tree.level(0)[i] = val;
+		_tree.update(i);
+	}
+
+};
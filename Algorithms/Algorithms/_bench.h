@@ -0,0 +1,204 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+	using bench_type = std::function<void()>;
+	using collection_type = std::vector<bench_type>;
+
+	enum class format { csv, json };
+
+	extern collection_type _collection;
+	extern format _format;
+
+	struct token {};
+
+	inline token add(const bench_type& bench)
+	{
+		_collection.push_back(bench);
+		return token{};
+	}
+
+	template<typename... TBenches>
+	token publish(TBenches&&... benches)
+	{
+		std::make_tuple(add(std::forward<TBenches>(benches))...);
+		return token{};
+	}
+
+	// csv has a header line, json is one object per line
+	inline void run(format f = format::csv)
+	{
+		_format = f;
+		if (_format == format::csv)
+		{
+			std::cout << "name,workload,size,ops,ns_per_op,mops_per_s,p50_ns,p99_ns" << std::endl;
+		}
+		for (const auto& bench : _collection)
+		{
+			bench();
+		}
+	}
+
+	// seconds spent in f()
+	template<typename TFunc>
+	double measure(TFunc&& f)
+	{
+		auto start = std::chrono::steady_clock::now();
+		f();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	struct result
+	{
+		std::string name;
+		std::string workload;
+		long long size;
+		long long ops;
+		double seconds;
+		// latencies of single operations, negative if not measured
+		double p50_ns;
+		double p99_ns;
+
+		result() : size(0), ops(0), seconds(0), p50_ns(-1), p99_ns(-1) {}
+	};
+
+	inline void report(const result& res)
+	{
+		double ns = res.seconds * 1e9 / res.ops;
+		double mops = res.ops / res.seconds / 1e6;
+
+		if (_format == format::csv)
+		{
+			std::cout << res.name << "," << res.workload << "," << res.size << "," << res.ops << ","
+				<< ns << "," << mops << ",";
+			if (res.p50_ns >= 0) std::cout << res.p50_ns << "," << res.p99_ns;
+			else std::cout << ",";
+			std::cout << std::endl;
+			return;
+		}
+
+		std::cout << "{\"name\":\"" << res.name << "\",\"workload\":\"" << res.workload
+			<< "\",\"size\":" << res.size << ",\"ops\":" << res.ops
+			<< ",\"ns_per_op\":" << ns << ",\"mops_per_s\":" << mops;
+		if (res.p50_ns >= 0) std::cout << ",\"p50_ns\":" << res.p50_ns << ",\"p99_ns\":" << res.p99_ns;
+		std::cout << "}" << std::endl;
+	}
+
+	inline void report(const std::string& name, long long size, long long ops, double seconds)
+	{
+		result res;
+		res.name = name;
+		res.size = size;
+		res.ops = ops;
+		res.seconds = seconds;
+		report(res);
+	}
+
+	// keeps the optimizer from dropping unused results
+	template<typename T>
+	void consume(const T& value)
+	{
+		static volatile char sink;
+		sink = *reinterpret_cast<const volatile char*>(&value);
+		(void)sink;
+	}
+
+	// Updates and queries of ranges [l, r] of an array of size elements.
+	struct workload
+	{
+		std::string name;
+		int size;
+		int ops;
+		// share of updates, percent
+		int update_percent;
+		// range lengths are uniform in [1, max_len], max_len = size gives arbitrary ranges
+		int max_len;
+		// range starts are size * u^(1 + skew) for uniform u, skew > 0 makes the front hot
+		double skew;
+		// updates change single elements
+		bool point_updates;
+	};
+
+	struct operation
+	{
+		bool update;
+		int l, r;
+		int val;
+	};
+
+	inline std::vector<operation> generate(const workload& w, unsigned seed = 42)
+	{
+		std::mt19937 rnd(seed);
+		std::uniform_real_distribution<double> unit(0, 1);
+
+		std::vector<operation> res(w.ops);
+		for (auto& op : res)
+		{
+			op.update = int(rnd() % 100) < w.update_percent;
+			op.l = std::min(w.size - 1, int(w.size * std::pow(unit(rnd), 1 + w.skew)));
+			int len = (op.update && w.point_updates ? 1 : 1 + int(rnd() % w.max_len));
+			op.r = std::min(w.size - 1, op.l + len - 1);
+			op.val = int(rnd() % 21) - 10;
+		}
+		return res;
+	}
+
+	// update(t, op) applies an update, query(t, op) returns a value to consume.
+	// The throughput run is timed as a whole, the latency run times every operation
+	// on a fresh tree, so the percentiles include the clock overhead.
+	template<typename TTree, typename TUpdate, typename TQuery>
+	void run_workload(const std::string& name, const workload& w, const std::vector<operation>& ops,
+		TUpdate update, TQuery query)
+	{
+		result res;
+		res.name = name;
+		res.workload = w.name;
+		res.size = w.size;
+		res.ops = ops.size();
+
+		{
+			TTree t;
+			t.assign(w.size);
+			long long acc = 0;
+			res.seconds = measure([&]()
+			{
+				for (const auto& op : ops)
+				{
+					if (op.update) update(t, op);
+					else acc += query(t, op);
+				}
+			});
+			consume(acc);
+		}
+
+		{
+			TTree t;
+			t.assign(w.size);
+			long long acc = 0;
+			std::vector<double> ns(ops.size());
+			for (size_t i = 0; i < ops.size(); ++i)
+			{
+				auto start = std::chrono::steady_clock::now();
+				if (ops[i].update) update(t, ops[i]);
+				else acc += query(t, ops[i]);
+				ns[i] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			}
+			consume(acc);
+
+			std::nth_element(ns.begin(), ns.begin() + ns.size() / 2, ns.end());
+			res.p50_ns = ns[ns.size() / 2];
+			std::nth_element(ns.begin(), ns.begin() + ns.size() * 99 / 100, ns.end());
+			res.p99_ns = ns[ns.size() * 99 / 100];
+		}
+
+		report(res);
+	}
+}
@@ -6,6 +6,7 @@
 #include <cmath>
 #include <cctype>
 #include <cassert>
+#include <climits>
  
 #include <algorithm>
 #include <iostream>
@@ -21,10 +22,13 @@
 #include <iterator>
 #include <functional>
 #include <numeric>
+#include <type_traits>
 
 #include <unordered_set>
 #include <unordered_map>
 #include <random>
+#include <future>
+#include <thread>
  
 using namespace std;
  
@@ -40,7 +40,7 @@ struct SegmentTree
 	{
 		if (l == ll && r == rr)
 		{
-			return mp(v[i], p[i]);
+			return make_pair(v[i], p[i]);
 		}
 		
 		int m = M(l, r);
@@ -66,18 +66,161 @@ struct SegmentTree
 	}
 };
 
+// O(1) min queries, O(n log n) memory: level k keeps the position of the min of [i, i + 2^k) at k * n + i.
+struct SparseTable
+{
+	int n;
+	vint v;
+	vint lg;
+	vint t;
+
+	void Init(const vint & a)
+	{
+		n = a.size();
+		v = a;
+		lg.assign(n + 1, 0);
+		for (int i = 2; i <= n; ++i)
+		{
+			lg[i] = lg[i >> 1] + 1;
+		}
+
+		int levels = lg[max(n, 1)] + 1;
+		t.resize(size_t(levels) * n);
+		forn(i, n)
+		{
+			t[i] = i;
+		}
+		for (int k = 1; k < levels; ++k)
+		{
+			int * cur = &t[size_t(k) * n];
+			const int * prev = &t[size_t(k - 1) * n];
+			int half = 1 << (k - 1);
+			for (int i = 0; i + 2 * half <= n; ++i)
+			{
+				cur[i] = Better(prev[i], prev[i + half]);
+			}
+		}
+	}
+
+	// the leftmost of equal values
+	int Better(int i, int j) const
+	{
+		return v[j] < v[i] ? j : i;
+	}
+
+	int MinPos(int l, int r) const
+	{
+		int k = lg[r - l + 1];
+		return Better(t[size_t(k) * n + l], t[size_t(k) * n + r - (1 << k) + 1]);
+	}
+};
+
+// Farach-Colton and Bender: O(1) min queries with O(n) memory for arrays whose neighbours differ by one,
+// as the depths of an Euler tour. The array is cut into blocks of b = log(n) / 2,
+// a SparseTable over the block minima answers runs of whole blocks, and the rest of a query is answered
+// by the table of its block type, the mask of the steps up. There are 2^(b-1) <= sqrt(n) types.
+struct PlusMinusOneRmq
+{
+	int n;
+	int b;
+	vint v;
+	vint type;
+	vint blockPos;
+	// position of the min of [l, r] of a block of type tp at (tp * b + l) * b + r
+	vector<unsigned char> inner;
+	SparseTable blocks;
+
+	void Init(const vint & a)
+	{
+		n = a.size();
+		v = a;
+		int lg = 0;
+		while ((2 << lg) <= n) ++lg;
+		b = max(1, lg / 2);
+
+		int count = (n + b - 1) / b;
+		type.assign(count, 0);
+		blockPos.resize(count);
+		vint mins(count);
+		forn(k, count)
+		{
+			int from = k * b;
+			int to = min(n, from + b);
+			int best = from;
+			for (int i = from + 1; i < from + b; ++i)
+			{
+				// the missing end of the last block goes up
+				if (i >= to || v[i] > v[i - 1]) type[k] |= 1 << (i - from - 1);
+				if (i < to && v[i] < v[best]) best = i;
+			}
+			blockPos[k] = best;
+			mins[k] = v[best];
+		}
+		blocks.Init(mins);
+
+		int types = 1 << (b - 1);
+		inner.resize(size_t(types) * b * b);
+		forn(tp, types)
+		{
+			forn(l, b)
+			{
+				unsigned char * row = &inner[(size_t(tp) * b + l) * b];
+				int d = 0, minD = 0, best = l;
+				row[l] = l;
+				for (int r = l + 1; r < b; ++r)
+				{
+					d += ((tp >> (r - 1)) & 1) ? 1 : -1;
+					if (d < minD)
+					{
+						minD = d;
+						best = r;
+					}
+					row[r] = best;
+				}
+			}
+		}
+	}
+
+	// l and r inside block k
+	int InBlock(int k, int l, int r) const
+	{
+		int from = k * b;
+		return from + inner[(size_t(type[k]) * b + l - from) * b + r - from];
+	}
+
+	int MinPos(int l, int r) const
+	{
+		int bl = l / b, br = r / b;
+		if (bl == br) return InBlock(bl, l, r);
+
+		int res = InBlock(bl, l, bl * b + b - 1);
+		if (bl + 1 < br)
+		{
+			int m = blockPos[blocks.MinPos(bl + 1, br - 1)];
+			if (v[m] < v[res]) res = m;
+		}
+		int right = InBlock(br, br * b, r);
+		if (v[right] < v[res]) res = right;
+		return res;
+	}
+};
+
 struct Node
 {
 	vint to;
 };
 
-struct Lca
+// LCA as the min depth between the Euler tour positions of the nodes.
+// TRmq has Init(const vint &) and MinPos(l, r): SegmentTree answers in O(log n),
+// SparseTable in O(1) with O(n log n) memory, PlusMinusOneRmq in O(1) with O(n) memory.
+template<typename TRmq>
+struct BasicLca
 {
 	int n;
 	vint w;
 	vint deep;
 	vint pos;
-	SegmentTree st;
+	TRmq st;
 
 	void Init(const vector<Node> & g)
 	{
@@ -113,10 +256,12 @@ struct Lca
 		}
 	}
 
-	int GetLca(int a, int b)
+	int GetLca(int a, int b) const
 	{
 		if (pos[a] > pos[b])
 			swap(a, b);
 		return w[st.MinPos(pos[a], pos[b])];
 	}
-};
\ No newline at end of file
+};
+
+using Lca = BasicLca<SparseTable>;